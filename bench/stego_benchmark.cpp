@@ -0,0 +1,491 @@
+// Steganography benchmarks
+// Usage: stego_benchmark [Google Benchmark flags]
+
+// Description
+// Benchmarks every stage the programs report (loading, noise generation, slot
+// counting, shuffling, embedding, extracting and saving) of parts A to E on
+// synthetic carriers of 1 to 100 megapixels. Payloads are given as fill
+// ratio: the percentage of black (0 bit) message pixels for parts A, B and D
+// and the percentage of carrier capacity for part E. Results are written as
+// JSON for comparison between releases with
+//
+//   stego_benchmark --benchmark_out=results.json --benchmark_out_format=json
+//
+// and single benchmarks are picked with --benchmark_filter (100 megapixel
+// carriers take about 300 MB each, part E payloads up to 40 MB more).
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <opencv2/core/core.hpp>
+#include "stego/stego.h"
+
+using namespace cv;
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+const vector<int64_t> megapixels = {1, 4, 16, 100};
+const vector<int64_t> fill_percents = {1, 10, 50, 90};
+const stego::seed_t seed = 0x5EED;
+
+// 4:3 carrier of about mp megapixels
+Size carrier_size(int64_t mp)
+{
+    auto cols = int(lround(sqrt(mp * 1e6 * 4 / 3)));
+    return Size(cols, int(mp * 1000000 / cols));
+}
+
+// synthetic carriers are made once per size (and reused by every benchmark)
+const Mat_<Vec3b>& color_carrier(int64_t mp)
+{
+    static map<int64_t, Mat_<Vec3b>> carriers;
+    auto& carrier = carriers[mp];
+    if (carrier.empty()) {
+        carrier.create(carrier_size(mp));
+        stego::chacha_rng rng(mp);
+        auto bytes = carrier.ptr<uchar>();
+        for (size_t i = 0; i < carrier.total() * 3; i += 4) {
+            auto word = rng.next();
+            for (size_t j = i; j < min(i + 4, carrier.total() * 3); ++j) {
+                bytes[j] = uchar(word);
+                word >>= 8;
+            }
+        }
+    }
+    return carrier;
+}
+
+const Mat_<uchar>& gray_carrier(int64_t mp)
+{
+    static map<int64_t, Mat_<uchar>> carriers;
+    auto& carrier = carriers[mp];
+    if (carrier.empty()) {
+        const auto& color = color_carrier(mp);
+        carrier.create(color.size());
+        auto bytes = color.ptr<uchar>();
+        for (size_t i = 0; i < carrier.total(); ++i)
+            carrier.ptr<uchar>()[i] = bytes[3 * i];
+    }
+    return carrier;
+}
+
+// message plane of carrier size, fill percent of pixels black
+const stego::bit_plane& message(int64_t mp, int64_t fill)
+{
+    static map<pair<int64_t, int64_t>, stego::bit_plane> messages;
+    auto& plane = messages[{mp, fill}];
+    if (plane.empty()) {
+        auto size = carrier_size(mp);
+        plane = stego::bit_plane(size);
+        stego::chacha_rng rng(mp * 100 + fill);
+        for (int r = 0; r < size.height; ++r)
+            for (int c = 0; c < size.width; ++c)
+                plane.set(r, c, rng(100) >= fill);
+    }
+    return plane;
+}
+
+// carrier written once per size and format to the temporary directory
+string carrier_file(int64_t mp, bool raw)
+{
+    static map<pair<int64_t, bool>, string> paths;
+    auto& path = paths[{mp, raw}];
+    if (path.empty()) {
+        auto name = "stego_benchmark_" + to_string(mp);
+        path = (fs::temp_directory_path() / (name + (raw ? ".sraw" : ".png")))
+                   .string();
+        stego::write_image(path, color_carrier(mp));
+    }
+    return path;
+}
+
+void set_counters(benchmark::State& state, int64_t mp, uint64_t bytes)
+{
+    state.SetBytesProcessed(int64_t(state.iterations() * bytes));
+    state.counters["megapixels"] = double(mp);
+}
+
+// loading and saving, format 0 for PNG and 1 for raw images
+
+void load(benchmark::State& state)
+{
+    auto mp = state.range(0);
+    auto path = carrier_file(mp, state.range(1));
+    for (auto _ : state) {
+        stego::image_file file(path);
+        benchmark::DoNotOptimize(file.image().data);
+    }
+    set_counters(state, mp, color_carrier(mp).total() * 3);
+}
+
+void save(benchmark::State& state)
+{
+    auto mp = state.range(0);
+    const auto& carrier = color_carrier(mp);
+    auto path = (fs::temp_directory_path() /
+                 (string("stego_benchmark_save") +
+                  (state.range(1) ? ".sraw" : ".png")))
+                    .string();
+    for (auto _ : state)
+        if (!stego::write_image(path, carrier))
+            state.SkipWithError("Could not save");
+    fs::remove(path);
+    set_counters(state, mp, carrier.total() * 3);
+}
+
+// noise generation with noise_generator legacy, counter or chacha
+
+void noise(benchmark::State& state)
+{
+    auto mp = state.range(0);
+    auto generator = stego::noise_generator(state.range(1));
+    const auto& carrier = color_carrier(mp);
+    Mat_<Vec3b> noised;
+    for (auto _ : state) {
+        if (generator == stego::noise_generator::legacy) {
+            RNG rng(seed);
+            stego::add_gaussian_noise(carrier, noised, 5, rng);
+        } else {
+            stego::add_gaussian_noise(carrier, noised, 5, seed, generator);
+        }
+        benchmark::DoNotOptimize(noised.data);
+    }
+    set_counters(state, mp, carrier.total() * 3);
+}
+
+// slot counting and whole-table shuffling (legacy part E order) with
+// random_generator cv_rng or chacha
+
+void slot_count(benchmark::State& state)
+{
+    auto mp = state.range(0);
+    const auto& carrier = color_carrier(mp);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(stego::free_slots<uint32_t>(carrier).data());
+    set_counters(state, mp, carrier.total() * 3);
+}
+
+void shuffle(benchmark::State& state)
+{
+    auto mp = state.range(0);
+    auto slots = stego::free_slots<uint32_t>(color_carrier(mp));
+    for (auto _ : state) {
+        // shuffling the already shuffled table costs the same
+        if (stego::random_generator(state.range(1)) ==
+            stego::random_generator::chacha) {
+            stego::chacha_rng rng(seed);
+            stego::shuffle(slots.begin(), slots.end(), rng);
+        } else {
+            RNG rng(seed);
+            stego::shuffle(slots.begin(), slots.end(), rng);
+        }
+        benchmark::DoNotOptimize(slots.data());
+    }
+    set_counters(state, mp, slots.size() * sizeof(uint32_t));
+}
+
+// part A and B embedding and extracting (gray carriers)
+
+template <typename Encode>
+void embed_gray(benchmark::State& state, Encode encode)
+{
+    auto mp = state.range(0);
+    const auto& carrier = gray_carrier(mp);
+    const auto& plane = message(mp, state.range(1));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(encode(carrier, plane).data);
+    set_counters(state, mp, carrier.total());
+    state.counters["fill"] = double(state.range(1));
+}
+
+template <typename Encode, typename Decode>
+void extract_gray(benchmark::State& state, Encode encode, Decode decode)
+{
+    auto mp = state.range(0);
+    const auto& carrier = gray_carrier(mp);
+    Mat_<uchar> encoded = encode(carrier, message(mp, state.range(1)));
+    for (auto _ : state) {
+        auto decoded = decode(carrier, encoded);
+        benchmark::DoNotOptimize(decoded);
+    }
+    set_counters(state, mp, carrier.total());
+    state.counters["fill"] = double(state.range(1));
+}
+
+void part_a_embed(benchmark::State& state)
+{
+    embed_gray(state, [](const Mat_<uchar>& carrier,
+                         const stego::bit_plane& plane) {
+        return stego::part_a::encode(carrier, plane);
+    });
+}
+
+void part_a_extract(benchmark::State& state)
+{
+    extract_gray(
+        state,
+        [](const Mat_<uchar>& carrier, const stego::bit_plane& plane) {
+            return stego::part_a::encode(carrier, plane);
+        },
+        [](const Mat_<uchar>& carrier, const Mat_<uchar>& encoded) {
+            return stego::part_a::decode_bits(carrier, encoded);
+        });
+}
+
+void part_b_embed(benchmark::State& state)
+{
+    embed_gray(state, [](const Mat_<uchar>& carrier,
+                         const stego::bit_plane& plane) {
+        return stego::part_b::encode(carrier, plane, seed);
+    });
+}
+
+void part_b_extract(benchmark::State& state)
+{
+    extract_gray(
+        state,
+        [](const Mat_<uchar>& carrier, const stego::bit_plane& plane) {
+            return stego::part_b::encode(carrier, plane, seed);
+        },
+        [](const Mat_<uchar>& carrier, const Mat_<uchar>& encoded) {
+            return stego::part_b::decode_bits(carrier, encoded, seed);
+        });
+}
+
+// part C noise images (sigma 10) with noise_generator legacy, counter or
+// chacha
+
+void part_c_noise(benchmark::State& state)
+{
+    auto mp = state.range(0);
+    const auto& carrier = color_carrier(mp);
+    auto generator = stego::noise_generator(state.range(1));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(
+            stego::part_c::noise(carrier, seed, 10, generator).data);
+    set_counters(state, mp, carrier.total() * 3);
+}
+
+// part D slot choice (part_d::order legacy or permutation), embedding and
+// extracting
+
+void part_d_prepare(benchmark::State& state)
+{
+    auto mp = state.range(0);
+    const auto& carrier = color_carrier(mp);
+    auto slot_order = stego::part_d::order(state.range(1));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(
+            stego::part_d::prepare(carrier, seed, slot_order).slots.data());
+    set_counters(state, mp, carrier.total() * 3);
+}
+
+const stego::part_d::prepared_carrier& part_d_prepared(int64_t mp)
+{
+    static map<int64_t, stego::part_d::prepared_carrier> prepared;
+    auto it = prepared.find(mp);
+    if (it == prepared.end())
+        it = prepared
+                 .emplace(mp, stego::part_d::prepare(color_carrier(mp), seed))
+                 .first;
+    return it->second;
+}
+
+void part_d_embed(benchmark::State& state)
+{
+    auto mp = state.range(0);
+    const auto& prepared = part_d_prepared(mp);
+    const auto& plane = message(mp, state.range(1));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(stego::part_d::encode(prepared, plane).data);
+    set_counters(state, mp, prepared.carrier.total() * 3);
+    state.counters["fill"] = double(state.range(1));
+}
+
+void part_d_extract(benchmark::State& state)
+{
+    auto mp = state.range(0);
+    const auto& prepared = part_d_prepared(mp);
+    auto encoded =
+        stego::part_d::encode(prepared, message(mp, state.range(1)));
+    for (auto _ : state) {
+        auto decoded = stego::part_d::decode_bits(prepared, encoded);
+        benchmark::DoNotOptimize(decoded);
+    }
+    set_counters(state, mp, prepared.carrier.total() * 3);
+    state.counters["fill"] = double(state.range(1));
+}
+
+// part E preparation with legacy, cv::RNG (Philox noise) or default (ChaCha)
+// options, embedding and extracting with additive, LSB matching or LSB
+// replacement embedding
+
+stego::part_e::options part_e_options(int64_t variant)
+{
+    stego::part_e::options opts;
+    if (variant == 0) {
+        opts = stego::part_e::options::legacy();
+    } else if (variant == 1) {
+        opts.noise = stego::noise_generator::counter;
+        opts.slot_generator = stego::random_generator::cv_rng;
+    }
+    return opts;
+}
+
+void part_e_prepare(benchmark::State& state)
+{
+    auto mp = state.range(0);
+    const auto& carrier = color_carrier(mp);
+    auto opts = part_e_options(state.range(1));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(
+            stego::part_e::prepare(carrier, seed, opts).noised.data);
+    set_counters(state, mp, carrier.total() * 3);
+}
+
+const stego::part_e::prepared_carrier& part_e_prepared(int64_t mp,
+                                                       int64_t embed)
+{
+    static map<pair<int64_t, int64_t>, stego::part_e::prepared_carrier>
+        prepared;
+    auto it = prepared.find({mp, embed});
+    if (it == prepared.end()) {
+        stego::part_e::options opts;
+        opts.embed = stego::part_e::embedding(embed);
+        it = prepared
+                 .emplace(make_pair(mp, embed),
+                          stego::part_e::prepare(color_carrier(mp), seed,
+                                                 opts))
+                 .first;
+    }
+    return it->second;
+}
+
+// payload of fill percent of capacity
+vector<char> payload(const stego::part_e::prepared_carrier& prepared,
+                     int64_t fill)
+{
+    vector<char> data(size_t(stego::part_e::capacity(prepared) * fill / 100));
+    stego::chacha_rng rng(fill);
+    for (auto& byte : data)
+        byte = char(rng.next());
+    return data;
+}
+
+void part_e_embed(benchmark::State& state)
+{
+    auto mp = state.range(0);
+    const auto& prepared = part_e_prepared(mp, state.range(2));
+    auto data = payload(prepared, state.range(1));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(
+            stego::part_e::encode(prepared, data.data(), data.size()).data);
+    set_counters(state, mp, data.size());
+    state.counters["fill"] = double(state.range(1));
+}
+
+void part_e_extract(benchmark::State& state)
+{
+    auto mp = state.range(0);
+    const auto& prepared = part_e_prepared(mp, state.range(2));
+    auto data = payload(prepared, state.range(1));
+    auto encoded = stego::part_e::encode(prepared, data.data(), data.size());
+    for (auto _ : state)
+        benchmark::DoNotOptimize(
+            stego::part_e::decode(prepared, encoded).data());
+    set_counters(state, mp, data.size());
+    state.counters["fill"] = double(state.range(1));
+}
+
+}  // namespace
+
+BENCHMARK(load)
+    ->ArgsProduct({megapixels, {0, 1}})
+    ->ArgNames({"mp", "raw"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(save)
+    ->ArgsProduct({megapixels, {0, 1}})
+    ->ArgNames({"mp", "raw"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(noise)
+    ->ArgsProduct({megapixels, {0, 1, 2}})
+    ->ArgNames({"mp", "generator"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(slot_count)
+    ->ArgsProduct({megapixels})
+    ->ArgNames({"mp"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(shuffle)
+    ->ArgsProduct({megapixels, {0, 1}})
+    ->ArgNames({"mp", "generator"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(part_a_embed)
+    ->ArgsProduct({megapixels, fill_percents})
+    ->ArgNames({"mp", "fill"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(part_a_extract)
+    ->ArgsProduct({megapixels, fill_percents})
+    ->ArgNames({"mp", "fill"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(part_b_embed)
+    ->ArgsProduct({megapixels, fill_percents})
+    ->ArgNames({"mp", "fill"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(part_b_extract)
+    ->ArgsProduct({megapixels, fill_percents})
+    ->ArgNames({"mp", "fill"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(part_c_noise)
+    ->ArgsProduct({megapixels, {0, 1, 2}})
+    ->ArgNames({"mp", "generator"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(part_d_prepare)
+    ->ArgsProduct({megapixels, {0, 1}})
+    ->ArgNames({"mp", "order"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(part_d_embed)
+    ->ArgsProduct({megapixels, fill_percents})
+    ->ArgNames({"mp", "fill"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(part_d_extract)
+    ->ArgsProduct({megapixels, fill_percents})
+    ->ArgNames({"mp", "fill"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(part_e_prepare)
+    ->ArgsProduct({megapixels, {0, 1, 2}})
+    ->ArgNames({"mp", "options"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(part_e_embed)
+    ->ArgsProduct({megapixels, fill_percents, {0, 1, 2}})
+    ->ArgNames({"mp", "fill", "embed"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(part_e_extract)
+    ->ArgsProduct({megapixels, fill_percents, {0, 1, 2}})
+    ->ArgNames({"mp", "fill", "embed"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
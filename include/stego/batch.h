@@ -0,0 +1,143 @@
+// Steganography library - batch processing
+
+// Description
+// Runs many encode/decode jobs of parts B, D and E in one process. Jobs are
+// read from a manifest, either CSV (header line naming the columns) or JSON
+// lines (one flat object per line), with the fields:
+//
+//   tool      b_encoder, b_decoder, d_encoder, d_decoder, e_encoder or
+//             e_decoder
+//   carrier   carrier image (not needed by blind e_decoder jobs)
+//   input     message (image or file) for encoders, encoded image for
+//             decoders
+//   output    encoded image for encoders, decoded message for decoders
+//   password  optional, default password is used when missing or empty
+//   password_source
+//             optional instead of password, env:NAME, fd:N or file:PATH (see
+//             stego::read_password), every source is read once
+//   legacy    optional (true/false or 1/0), the same as --legacy of the tools
+//   blind     optional (true/false or 1/0), part E only; e_encoder embeds
+//             with --lsb matching, e_decoder decodes with --blind
+//   bits      optional (1 to 4), part E only, the same as --bits of the tools
+//   compress  optional (none or deflate), e_encoder only, the same as
+//             --compress of the tool
+//   header    optional (true/false or 1/0, default true), part E only;
+//             false is the same as --no-header of the tools
+//   key       optional, the same as --key of the tools (djb2 for legacy jobs
+//             when missing)
+//   rng       optional (cv or chacha), part E only, the same as --rng of the
+//             tools
+//
+// Decoded carrier images, prepared (noised) part E carriers and seeds derived
+// from passwords are cached and shared by jobs running on a pool of worker
+// threads. A runner keeps these caches warm between jobs given to it one at
+// a time, as a long-running server does.
+
+#ifndef STEGO_BATCH_H
+#define STEGO_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include <memory>
+#include <tuple>
+#include <opencv2/core/core.hpp>
+#include "stego/carrier_cache.h"
+#include "stego/compression.h"
+#include "stego/image_io.h"
+#include "stego/key.h"
+#include "stego/lru_cache.h"
+
+namespace stego {
+namespace batch {
+
+enum class tool {
+    b_encoder,
+    b_decoder,
+    d_encoder,
+    d_decoder,
+    e_encoder,
+    e_decoder
+};
+
+struct job {
+    std::size_t line = 0;  // in manifest
+    tool program = tool::e_encoder;
+    std::string carrier;
+    std::string input;
+    std::string output;
+    bool has_password = false;
+    std::string password;
+    bool legacy = false;
+    bool blind = false;
+    int bits = 1;  // part E bits per slot
+    compression compress = compression::none;  // e_encoder only
+    bool cv_rng = false;  // part E cv::RNG slots and Philox noise
+    bool header = true;   // part E payload header (off for legacy jobs)
+    key_params key;
+};
+
+struct result {
+    std::size_t line = 0;  // of the job in manifest
+    bool ok = false;
+    std::string message;  // error description when not ok
+    double milliseconds = 0;
+};
+
+struct settings {
+    unsigned threads = 0;  // 0 means one per CPU
+    std::size_t cache_bytes = std::size_t(1) << 30;
+    std::string cache_directory;  // prepared carriers kept on disk when set
+    int png_level = default_png_level;
+    std::string password;  // for jobs without one
+};
+
+// throws stego::error naming the offending line
+std::vector<job> read_manifest(std::istream& manifest);
+
+// job of one JSON object (a JSON lines manifest line), throws stego::error;
+// for requests of other processes (e.g. daemon clients), so password_source
+// is rejected: sources name descriptors, files and environment of this
+// process, which only its own operator may read
+job parse_job(const std::string& line, std::size_t line_number = 1);
+
+// runs jobs over caches shared by every job it runs; thread-safe
+class runner {
+public:
+    explicit runner(const settings& config);
+
+    // never throws, failures are reported in the result
+    result run(const job& task);
+
+private:
+    // path, imread flags, file size and modification time
+    using image_key =
+        std::tuple<std::string, int, std::uintmax_t, std::int64_t>;
+
+    void execute(const job& task);
+    void save(const std::string& path, const cv::Mat& image) const;
+    cv::Mat image(const std::string& path, int flags);
+    std::shared_ptr<const part_d::prepared_carrier> prepared_d(
+        const job& task, seed_t seed);
+    std::shared_ptr<const part_e::prepared_carrier> prepared_e(
+        const job& task, seed_t seed);
+
+    settings config_;
+    lru_cache<image_key, cv::Mat> images_;
+    carrier_cache prepared_;
+    key_cache keys_;
+};
+
+// runs every job, report is called (one call at a time) as jobs finish
+void run(const std::vector<job>& jobs, const settings& config,
+         const std::function<void(const job&, const result&)>& report);
+
+const char* tool_name(tool program);
+
+}  // namespace batch
+}  // namespace stego
+
+#endif  // STEGO_BATCH_H
@@ -0,0 +1,87 @@
+// Steganography library - bit planes
+
+// Description
+// Binary message images are held as packed bit planes: one bit per pixel
+// (set for white, clear for black), 64 pixels per word, every row starting
+// at a new word. A plane takes an eighth of the memory of the equivalent
+// 8-bit image; 0/255 images are only produced when a plane is saved.
+
+#ifndef STEGO_BIT_PLANE_H
+#define STEGO_BIT_PLANE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+namespace stego {
+
+class bit_plane {
+public:
+    bit_plane() = default;
+
+    // all pixels black
+    bit_plane(int rows, int cols);
+    explicit bit_plane(cv::Size size) : bit_plane(size.height, size.width) {}
+
+    // pixels different from 0 are white (like threshold at 0)
+    static bit_plane from_image(const cv::Mat_<uchar>& image);
+
+    // image of 0 (black) and 255 (white) pixels
+    cv::Mat_<uchar> to_image() const;
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    cv::Size size() const { return cv::Size(cols_, rows_); }
+    bool empty() const { return words_.empty(); }
+
+    // bit col % 64 of word col / 64 holds pixel col of a row; bits past
+    // the last column are always clear
+    std::size_t words_per_row() const { return words_per_row_; }
+    std::uint64_t* row(int r) { return words_.data() + r * words_per_row_; }
+    const std::uint64_t* row(int r) const
+    {
+        return words_.data() + r * words_per_row_;
+    }
+
+    bool get(int r, int c) const { return row(r)[c / 64] >> (c % 64) & 1; }
+    void set(int r, int c, bool white)
+    {
+        auto& word = row(r)[c / 64];
+        auto mask = std::uint64_t(1) << (c % 64);
+        word = white ? word | mask : word & ~mask;
+    }
+
+    // number of white pixels
+    std::size_t count() const;
+
+    bool operator==(const bit_plane& other) const
+    {
+        return rows_ == other.rows_ && cols_ == other.cols_ &&
+               words_ == other.words_;
+    }
+    bool operator!=(const bit_plane& other) const { return !(*this == other); }
+
+private:
+    int rows_ = 0;
+    int cols_ = 0;
+    std::size_t words_per_row_ = 0;
+    std::vector<std::uint64_t> words_;
+};
+
+// number of set bits of word
+inline int popcount(std::uint64_t word)
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(word);
+#else
+    word -= (word >> 1) & 0x5555555555555555;
+    word = (word & 0x3333333333333333) + ((word >> 2) & 0x3333333333333333);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0F;
+    return int((word * 0x0101010101010101) >> 56);
+#endif
+}
+
+}  // namespace stego
+
+#endif  // STEGO_BIT_PLANE_H
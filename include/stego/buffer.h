@@ -0,0 +1,47 @@
+// Steganography library - caller-owned buffers
+
+// Description
+// Pixel buffers owned by the caller (decoded video frames, images of another
+// library...) are described by pointer, dimensions, number of channels and
+// stride, and wrapped in matrix headers without copying. Every part works on
+// wrapped buffers; part E also encodes into and decodes out of caller
+// buffers directly (see stego/part_e.h).
+
+#ifndef STEGO_BUFFER_H
+#define STEGO_BUFFER_H
+
+#include <cstddef>
+#include <opencv2/core/core.hpp>
+
+namespace stego {
+
+// read-only 8-bit image: rows of cols pixels of channels (1 or 3) bytes
+// each, rows stride bytes apart (0 for rows packed without gaps)
+struct pixel_view {
+    const unsigned char* data = nullptr;
+    int rows = 0;
+    int cols = 0;
+    int channels = 3;
+    std::size_t stride = 0;
+};
+
+// the same, writable
+struct pixel_buffer {
+    unsigned char* data = nullptr;
+    int rows = 0;
+    int cols = 0;
+    int channels = 3;
+    std::size_t stride = 0;
+
+    operator pixel_view() const { return {data, rows, cols, channels, stride}; }
+};
+
+// matrix headers over buffers (no copy), valid as long as the buffers are;
+// throw stego::error on null data, wrong channels or stride shorter than a
+// row; matrices over views must not be written to
+cv::Mat wrap(const pixel_view& view);
+cv::Mat wrap(const pixel_buffer& buffer);
+
+}  // namespace stego
+
+#endif  // STEGO_BUFFER_H
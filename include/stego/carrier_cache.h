@@ -0,0 +1,72 @@
+// Steganography library - prepared carrier cache
+
+// Description
+// Preparing a carrier (noising it, finding and shuffling its free slots) is
+// the expensive part of decoding and depends only on the carrier and the
+// password seed. Prepared carriers are therefore kept in memory (LRU limited
+// by bytes) and optionally in a directory (limited by total size of files,
+// least recently used files are deleted first), keyed by content hash of the
+// carrier and the seed. Repeated extraction against a known carrier then
+// costs the read-out only.
+//
+// Cache files are derived from passwords and must be protected like them.
+// They are written in native byte order.
+
+#ifndef STEGO_CARRIER_CACHE_H
+#define STEGO_CARRIER_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <opencv2/core/core.hpp>
+#include "stego/common.h"
+#include "stego/lru_cache.h"
+#include "stego/part_d.h"
+#include "stego/part_e.h"
+
+namespace stego {
+
+// 64-bit hash of dimensions, type and pixel data of image
+std::uint64_t content_hash(const cv::Mat& image);
+
+class carrier_cache {
+public:
+    // directory is not used when empty, disk_bytes of 0 means no limit
+    explicit carrier_cache(std::size_t memory_bytes,
+                           std::string directory = std::string(),
+                           std::uint64_t disk_bytes = std::uint64_t(4) << 30);
+
+    // return prepared carrier from cache, preparing (and caching) it first
+    // when missing
+    std::shared_ptr<const part_d::prepared_carrier> prepare_d(
+        const cv::Mat_<cv::Vec3b>& carrier, seed_t seed,
+        part_d::order slot_order);
+    std::shared_ptr<const part_e::prepared_carrier> prepare_e(
+        const cv::Mat_<cv::Vec3b>& carrier, seed_t seed,
+        const part_e::options& opts);
+
+private:
+    // content hash, seed, part and variant of preparation (options)
+    using key = std::tuple<std::uint64_t, seed_t, int, int>;
+
+    struct entry {
+        std::shared_ptr<const part_d::prepared_carrier> d;
+        std::shared_ptr<const part_e::prepared_carrier> e;
+    };
+
+    std::string file_name(const key& k) const;
+    bool load(const key& k, const cv::Mat_<cv::Vec3b>& carrier,
+              entry& found) const;
+    void store(const key& k, const entry& prepared) const;
+    void trim_directory() const;
+
+    lru_cache<key, entry> memory_;
+    std::string directory_;
+    std::uint64_t disk_bytes_;
+};
+
+}  // namespace stego
+
+#endif  // STEGO_CARRIER_CACHE_H
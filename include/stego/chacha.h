@@ -0,0 +1,76 @@
+// Steganography library - stream cipher generator
+
+// Description
+// The ChaCha stream cipher (Bernstein, "ChaCha, a variant of Salsa20") with 8
+// rounds, keyed by a seed, used as random number generator. Every 64-byte
+// keystream block depends on seed, stream number and block counter only, so
+// output is the same on every platform and compiler, and blocks far into a
+// stream cost no more than the first one (noise is generated in parallel
+// this way).
+
+#ifndef STEGO_CHACHA_H
+#define STEGO_CHACHA_H
+
+#include <cstdint>
+#include "stego/common.h"
+
+namespace stego {
+
+// generators of password seeded random sequences (slot orders, shuffles)
+enum class random_generator {
+    // cv::RNG multiply-with-carry generator (images encoded before ChaCha
+    // generator was introduced)
+    cv_rng,
+    // ChaCha8 keystream
+    chacha
+};
+
+// independent streams of one seed; band b of a tiled image draws its slots
+// from stream tile_stream + b
+enum chacha_stream : std::uint64_t {
+    slot_stream = 0,
+    noise_stream = 1,
+    tile_stream = 2
+};
+
+// runs rounds ChaCha rounds (even number) on in and adds in to the result
+void chacha_core(const std::uint32_t in[16], std::uint32_t out[16],
+                 int rounds = 8);
+
+// keystream block counter of stream keyed by seed
+void chacha_block(seed_t seed, std::uint64_t stream, std::uint64_t counter,
+                  std::uint32_t out[16]);
+
+// sequential generator over one stream, a drop-in for cv::RNG in shuffles
+class chacha_rng {
+public:
+    explicit chacha_rng(seed_t seed, std::uint64_t stream = slot_stream)
+        : seed_(seed), stream_(stream)
+    {
+    }
+
+    // next 32 random bits
+    std::uint32_t next()
+    {
+        if (index_ == 16) {
+            chacha_block(seed_, stream_, counter_++, block_);
+            index_ = 0;
+        }
+        return block_[index_++];
+    }
+
+    // uniformly distributed integer from [0, n), n > 0 (without the modulo
+    // bias of cv::RNG)
+    unsigned operator()(unsigned n);
+
+private:
+    seed_t seed_;
+    std::uint64_t stream_;
+    std::uint64_t counter_ = 0;
+    std::uint32_t block_[16];
+    int index_ = 16;
+};
+
+}  // namespace stego
+
+#endif  // STEGO_CHACHA_H
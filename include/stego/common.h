@@ -0,0 +1,77 @@
+// Steganography library - common definitions
+
+// Description
+// Helpers shared by every part: password hashing, bit access inside
+// arbitrary variables, password seeded shuffling and the library error type.
+
+#ifndef STEGO_COMMON_H
+#define STEGO_COMMON_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+#include <opencv2/core/core.hpp>
+
+namespace stego {
+
+// 64-bit seed derived from user password
+using seed_t = std::uint64_t;
+
+// thrown by every engine when input cannot be encoded or decoded (wrong
+// dimensions, too small carrier, wrong password etc.)
+class error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// from http://www.cse.yorku.ca/~oz/hash.html; seeds of images encoded before
+// keyed derivation was introduced (see stego/key.h)
+seed_t hash_djb2(const char* str);
+
+// splitmix64 finalizer, spreads every input bit over the whole result
+inline std::uint64_t mix64(std::uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EB;
+    return x ^ (x >> 31);
+}
+
+// reads n-th bit of var, bytes counted from right
+template <typename T>
+inline bool get_bit(const T& var, unsigned n)
+{
+    return 1 & (((const char*)&var)[sizeof(T) - n / 8 - 1] >> (n % 8));
+}
+
+// sets (or clears) bit_index-th bit of var, bytes counted from right
+template <typename T>
+inline void set_bit(T& var, unsigned bit_index, bool value = true)
+{
+    auto& byte = ((char*)&var)[sizeof(T) - bit_index / 8 - 1];
+    if (value)
+        byte |= 1 << bit_index % 8;
+    else
+        byte &= ~(1 << bit_index % 8);
+}
+
+// shuffles [first, last) exactly the way std::random_shuffle(first, last, rng)
+// did (std::random_shuffle is gone since C++17 and images encoded with it
+// must still decode); rng is cv::RNG or any generator giving uniform
+// integers from [0, n) for rng(n)
+template <typename RandomIt, typename Generator>
+void shuffle(RandomIt first, RandomIt last, Generator& rng)
+{
+    if (first == last)
+        return;
+    for (auto i = first + 1; i != last; ++i) {
+        auto j = first + rng(unsigned(i - first + 1));
+        if (i != j)
+            std::iter_swap(i, j);
+    }
+}
+
+}  // namespace stego
+
+#endif  // STEGO_COMMON_H
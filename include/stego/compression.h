@@ -0,0 +1,79 @@
+// Steganography library - payload compression
+
+// Description
+// Hidden files may be compressed before they are embedded, so that text-like
+// payloads take fewer carrier slots. Compression runs as a streaming stage:
+// input is given chunk by chunk and output handed to a sink as it is
+// produced, so memory use does not depend on file size. The method is
+// recorded in the part E payload header (as its algorithm id), so decoders
+// need not be told about it. New methods are added as new ids and cases of
+// compressor and decompressor.
+
+#ifndef STEGO_COMPRESSION_H
+#define STEGO_COMPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace stego {
+
+// ids are stored in hidden payload headers and must not change
+enum class compression : std::uint8_t {
+    none = 0,
+    deflate = 1  // raw DEFLATE stream (zlib)
+};
+
+// the last id known
+constexpr compression last_compression = compression::deflate;
+
+// "none" or "deflate", throws stego::error on anything else
+compression parse_compression(const std::string& text);
+
+// receives output of compressor and decompressor
+using byte_sink = std::function<void(const char* data, std::size_t size)>;
+
+class compressor {
+public:
+    // level 1 (fastest) to 9 (smallest)
+    explicit compressor(compression method, int level = 6);
+    ~compressor();
+    compressor(const compressor&) = delete;
+    compressor& operator=(const compressor&) = delete;
+
+    // compresses the next size bytes of input
+    void write(const char* data, std::size_t size, const byte_sink& sink);
+    // flushes the end of the stream
+    void finish(const byte_sink& sink);
+
+private:
+    struct stream;
+    compression method_;
+    std::unique_ptr<stream> stream_;
+};
+
+class decompressor {
+public:
+    explicit decompressor(compression method);
+    ~decompressor();
+    decompressor(const decompressor&) = delete;
+    decompressor& operator=(const decompressor&) = delete;
+
+    // decompresses the next size bytes of compressed stream, input past the
+    // end of the stream is ignored; throws stego::error on corrupted stream
+    void write(const char* data, std::size_t size, const byte_sink& sink);
+    // true once the end of the stream has been read
+    bool finished() const { return finished_; }
+
+private:
+    struct stream;
+    compression method_;
+    std::unique_ptr<stream> stream_;
+    bool finished_ = false;
+};
+
+}  // namespace stego
+
+#endif  // STEGO_COMPRESSION_H
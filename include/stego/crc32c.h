@@ -0,0 +1,43 @@
+// Steganography library - CRC32C
+
+// Description
+// CRC-32C (Castagnoli) checksums of hidden payloads, computed with the
+// SSE4.2 crc32 instruction where the CPU has it (checked at run time), the
+// ARMv8 CRC32 instructions where compiled in, and a lookup table elsewhere.
+// Large buffers are split into blocks checksummed in parallel, whose
+// checksums are then combined.
+
+#ifndef STEGO_CRC32C_H
+#define STEGO_CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace stego {
+
+// checksum of size bytes of data appended to data whose checksum is crc (0
+// for none), so that a stream is checksummed chunk by chunk
+std::uint32_t crc32c(const void* data, std::size_t size,
+                     std::uint32_t crc = 0);
+
+// checksum of two concatenated parts from their checksums, size2 being the
+// size of the second part
+std::uint32_t crc32c_combine(std::uint32_t crc1, std::uint32_t crc2,
+                             std::uint64_t size2);
+
+// the same for many second parts of one size, prepared once (4 KiB of
+// tables), so that every combination takes four table lookups
+class crc32c_combiner {
+public:
+    explicit crc32c_combiner(std::uint64_t size2);
+
+    std::uint32_t operator()(std::uint32_t crc1, std::uint32_t crc2) const;
+
+private:
+    // size2 zero bytes appended to each byte of a checksum
+    std::uint32_t table_[4][256];
+};
+
+}  // namespace stego
+
+#endif  // STEGO_CRC32C_H
@@ -0,0 +1,125 @@
+// Steganography library - image files
+
+// Description
+// Images are read and written either as PNG (or any other format known to
+// cv::imread) or as raw images, which skip compression altogether. A raw
+// image file (".sraw") is a 32-byte header followed by the interleaved pixel
+// bytes (BGR for colour images), row after row:
+//
+//   bytes  0-7   "STEGORAW"
+//   bytes  8-11  header size (32), little-endian like all the fields
+//   bytes 12-15  rows
+//   bytes 16-19  cols
+//   bytes 20-23  channels (1 or 3)
+//   bytes 24-31  zero
+//
+// Raw images are mapped into memory instead of being read, so loading them
+// costs no copy and created raw images are written in place. They are also
+// read and written band by band (see raw_reader and raw_writer) by the tiled
+// part E engine.
+
+#ifndef STEGO_IMAGE_IO_H
+#define STEGO_IMAGE_IO_H
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+namespace stego {
+
+// zlib level of written PNG images; 9 (the slowest) makes the smallest files
+constexpr int default_png_level = 1;
+
+// image loaded from (or created in) a file
+class image_file {
+public:
+    image_file() = default;
+
+    // loads image like cv::imread with IMREAD_GRAYSCALE or IMREAD_COLOR
+    // flags, image is empty when file cannot be read; raw images with the
+    // requested number of channels are mapped (copy on write), not read
+    image_file(const std::string& path, int flags = cv::IMREAD_COLOR);
+
+    // creates raw image file of type CV_8UC1 or CV_8UC3 mapped for writing
+    // in place, throws stego::error on failure
+    static image_file create(const std::string& path, int rows, int cols,
+                             int type);
+
+    image_file(image_file&& other) noexcept;
+    image_file& operator=(image_file&& other) noexcept;
+    ~image_file();
+
+    const cv::Mat& image() const { return image_; }
+    cv::Mat& image() { return image_; }
+
+    // true when image points into a mapped raw image file (and so is valid
+    // only as long as this image_file)
+    bool mapped() const { return mapping_ != nullptr; }
+
+private:
+    void unmap();
+
+    cv::Mat image_;
+    void* mapping_ = nullptr;
+    std::size_t mapping_bytes_ = 0;
+};
+
+// raw image file read a band of rows at a time, so that images of any size
+// are processed in bounded memory
+class raw_reader {
+public:
+    // throws stego::error when file is not a raw image
+    explicit raw_reader(const std::string& path);
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    int type() const { return type_; }
+
+    // reads count rows starting at first into image (allocated as count x
+    // cols matrix of type() unless it already is one), throws stego::error
+    void read(int first, int count, cv::Mat& image);
+
+private:
+    std::ifstream file_;
+    std::string path_;
+    int rows_ = 0;
+    int cols_ = 0;
+    int type_ = 0;
+};
+
+// raw image file written a band of rows at a time, in any order
+class raw_writer {
+public:
+    // writes header of rows x cols image of type CV_8UC1 or CV_8UC3, throws
+    // stego::error
+    raw_writer(const std::string& path, int rows, int cols, int type);
+
+    // writes rows of image (of cols columns and the type given) starting at
+    // row first, throws stego::error
+    void write(int first, const cv::Mat& image);
+
+    // throws stego::error unless every row has been written
+    void close();
+
+private:
+    std::ofstream file_;
+    std::string path_;
+    int rows_;
+    int cols_;
+    int type_;
+    int written_ = 0;
+};
+
+// true for paths of raw images (".sraw" extension)
+bool is_raw_path(const std::string& path);
+
+// writes 8-bit 1- or 3-channel image as raw image or with cv::imwrite
+// (PNG images compressed at png_level), returns false on failure
+bool write_image(const std::string& path, const cv::Mat& image,
+                 int png_level = default_png_level);
+
+}  // namespace stego
+
+#endif  // STEGO_IMAGE_IO_H
@@ -0,0 +1,87 @@
+// Steganography library - key derivation
+
+// Description
+// Passwords are turned into 64-bit seeds by one of the key derivation
+// functions below. The keyed hash (SipHash-2-4 under a fixed library key)
+// costs next to nothing and, unlike djb2, spreads every password byte over
+// the whole seed. Balloon hashing (Boneh, Corrigan-Gibbs and Schechter) is
+// memory-hard: every derivation fills and repeatedly mixes a buffer of
+// tunable size, making password guessing expensive. Images carry no salt,
+// so a fixed one is used.
+
+#ifndef STEGO_KEY_H
+#define STEGO_KEY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include "stego/common.h"
+#include "stego/lru_cache.h"
+
+namespace stego {
+
+enum class key_derivation {
+    // hash_djb2 (images encoded before keyed derivation was introduced)
+    djb2,
+    // SipHash-2-4
+    keyed,
+    // Balloon hashing over a ChaCha compression function
+    balloon
+};
+
+// largest Balloon hashing buffer (4 GiB)
+constexpr std::uint32_t max_balloon_kib = 4 * 1024 * 1024;
+
+struct key_params {
+    key_derivation method = key_derivation::keyed;
+    // Balloon hashing only: buffer size (up to max_balloon_kib) and number
+    // of passes over it
+    std::uint32_t memory_kib = 16 * 1024;
+    std::uint32_t passes = 3;
+
+    // parameters of images encoded before any of them were introduced
+    static key_params legacy() { return {key_derivation::djb2}; }
+
+    // "djb2", "keyed", "balloon" or "balloon:<memory KiB>:<passes>", throws
+    // stego::error on anything else (or memory over max_balloon_kib)
+    static key_params parse(const std::string& text);
+};
+
+// reads password (without line ending) from source, so programs can run
+// without a terminal:
+//
+//   env:NAME   environment variable NAME
+//   fd:N       first line read from open file descriptor N (e.g. a pipe)
+//   file:PATH  first line of key file PATH
+//
+// throws stego::error when source is unknown or cannot be read
+std::string read_password(const std::string& source);
+
+// SipHash-2-4 (Aumasson and Bernstein) of size bytes of data
+std::uint64_t siphash24(const void* data, std::size_t size, std::uint64_t k0,
+                        std::uint64_t k1);
+
+seed_t derive_seed(const std::string& password,
+                   const key_params& params = key_params());
+
+// derived seeds of recently used passwords, so that jobs sharing a password
+// pay for (memory-hard) derivation once; thread-safe
+class key_cache {
+public:
+    explicit key_cache(std::size_t entries = 64);
+
+    seed_t derive(const std::string& password,
+                  const key_params& params = key_params());
+
+private:
+    // passwords are not kept, only their keyed hash (under a per-cache key)
+    using key = std::tuple<std::uint64_t, int, std::uint32_t, std::uint32_t>;
+
+    lru_cache<key, seed_t> seeds_;
+    std::uint64_t hash_key_;
+};
+
+}  // namespace stego
+
+#endif  // STEGO_KEY_H
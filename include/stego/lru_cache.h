@@ -0,0 +1,99 @@
+// Steganography library - LRU cache
+
+// Description
+// Thread-safe map of shared, immutable values limited by total cost (e.g.
+// bytes); least recently used values are dropped when the limit is exceeded.
+// Values still in use elsewhere stay alive through their shared_ptr.
+
+#ifndef STEGO_LRU_CACHE_H
+#define STEGO_LRU_CACHE_H
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace stego {
+
+template <typename Key, typename Value>
+class lru_cache {
+public:
+    explicit lru_cache(std::size_t capacity) : capacity_(capacity) {}
+
+    // returns cached value (marking it as recently used) or nullptr
+    std::shared_ptr<const Value> find(const Key& key)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it == index_.end())
+            return nullptr;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->value;
+    }
+
+    // stores value replacing previous one with the same key; values costing
+    // more than the whole capacity are not stored
+    void insert(const Key& key, std::shared_ptr<const Value> value,
+                std::size_t cost = 1)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        erase(key);
+        if (cost > capacity_)
+            return;
+        entries_.push_front({key, std::move(value), cost});
+        index_[key] = entries_.begin();
+        total_cost_ += cost;
+        while (total_cost_ > capacity_)
+            erase(entries_.back().key);
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+        index_.clear();
+        total_cost_ = 0;
+    }
+
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+    std::size_t cost() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return total_cost_;
+    }
+
+private:
+    struct entry {
+        Key key;
+        std::shared_ptr<const Value> value;
+        std::size_t cost;
+    };
+
+    // mutex_ must be held
+    void erase(const Key& key)
+    {
+        auto it = index_.find(key);
+        if (it == index_.end())
+            return;
+        total_cost_ -= it->second->cost;
+        entries_.erase(it->second);
+        index_.erase(it);
+    }
+
+    std::size_t capacity_;
+    std::size_t total_cost_ = 0;
+    std::list<entry> entries_;
+    std::map<Key, typename std::list<entry>::iterator> index_;
+    mutable std::mutex mutex_;
+};
+
+}  // namespace stego
+
+#endif  // STEGO_LRU_CACHE_H
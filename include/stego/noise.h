@@ -0,0 +1,54 @@
+// Steganography library - noise generation
+
+// Description
+// Gaussian noise is the most commonly used noise model in image processing
+// and effectively describes most random noise encountered in the DIP
+// pipeline. Also known as additive noise.
+// (dip_notes2014.pdf)
+
+#ifndef STEGO_NOISE_H
+#define STEGO_NOISE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <opencv2/core/core.hpp>
+#include "stego/common.h"
+
+namespace stego {
+
+// generators of additive Gaussian noise
+enum class noise_generator {
+    // cv::RNG drawn serially for every byte (images encoded before counter
+    // generator was introduced)
+    legacy,
+    // Philox4x32-10 counter-based generator keyed by seed; noise of a byte
+    // depends on its position only, so image is processed in parallel and
+    // result does not depend on number of threads
+    counter,
+    // the same with ChaCha8 keystream blocks (stego/chacha.h) in place of
+    // Philox blocks
+    chacha
+};
+
+// adds Gaussian noise with given sigma to every channel of every pixel of src,
+// values are clamped to [0, 255]; src and dst may be the same matrix
+void add_gaussian_noise(const cv::Mat_<cv::Vec3b>& src,
+                        cv::Mat_<cv::Vec3b>& dst, double sigma, cv::RNG& rng);
+
+// the same using counter-based generator (counter or chacha), rows are
+// processed in parallel; first is the linear offset of the first byte of src
+// when it is a band of a larger image
+void add_gaussian_noise(const cv::Mat_<cv::Vec3b>& src,
+                        cv::Mat_<cv::Vec3b>& dst, double sigma, seed_t seed,
+                        noise_generator generator = noise_generator::counter,
+                        std::uint64_t first = 0);
+
+// adds counter-based Gaussian noise to count consecutive bytes whose linear
+// offset in the whole image starts at first; src and dst may be the same
+void add_gaussian_noise(const uchar* src, uchar* dst, std::size_t count,
+                        std::uint64_t first, double sigma, seed_t seed,
+                        noise_generator generator = noise_generator::counter);
+
+}  // namespace stego
+
+#endif  // STEGO_NOISE_H
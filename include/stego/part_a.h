@@ -0,0 +1,34 @@
+// Steganography library - Part A (Simple Steganography)
+
+// Description
+// Binary message image is added to a grayscale carrier image of the same
+// dimensions: every carrier pixel under a black message pixel is incremented.
+
+#ifndef STEGO_PART_A_H
+#define STEGO_PART_A_H
+
+#include <opencv2/core/core.hpp>
+#include "stego/bit_plane.h"
+#include "stego/common.h"
+
+namespace stego {
+namespace part_a {
+
+// returns carrier with message hidden in it
+cv::Mat_<uchar> encode(const cv::Mat_<uchar>& carrier,
+                       const cv::Mat_<uchar>& message);
+
+// returns message (0 or 255 pixels) recovered from encoded image
+cv::Mat_<uchar> decode(const cv::Mat_<uchar>& carrier,
+                       const cv::Mat_<uchar>& encoded);
+
+// the same on packed message planes (white pixels are set bits)
+cv::Mat_<uchar> encode(const cv::Mat_<uchar>& carrier,
+                       const bit_plane& message);
+bit_plane decode_bits(const cv::Mat_<uchar>& carrier,
+                      const cv::Mat_<uchar>& encoded);
+
+}  // namespace part_a
+}  // namespace stego
+
+#endif  // STEGO_PART_A_H
@@ -0,0 +1,34 @@
+// Steganography library - Part B (Scrambling the Signal)
+
+// Description
+// Consecutive bits of binary message image are hidden within password seeded
+// random ordered bytes of a grayscale carrier image.
+
+#ifndef STEGO_PART_B_H
+#define STEGO_PART_B_H
+
+#include <opencv2/core/core.hpp>
+#include "stego/bit_plane.h"
+#include "stego/common.h"
+
+namespace stego {
+namespace part_b {
+
+// returns carrier with message hidden in it
+cv::Mat_<uchar> encode(const cv::Mat_<uchar>& carrier,
+                       const cv::Mat_<uchar>& message, seed_t seed);
+
+// returns message (0 or 255 pixels) recovered from encoded image
+cv::Mat_<uchar> decode(const cv::Mat_<uchar>& carrier,
+                       const cv::Mat_<uchar>& encoded, seed_t seed);
+
+// the same on packed message planes (white pixels are set bits)
+cv::Mat_<uchar> encode(const cv::Mat_<uchar>& carrier,
+                       const bit_plane& message, seed_t seed);
+bit_plane decode_bits(const cv::Mat_<uchar>& carrier,
+                      const cv::Mat_<uchar>& encoded, seed_t seed);
+
+}  // namespace part_b
+}  // namespace stego
+
+#endif  // STEGO_PART_B_H
@@ -0,0 +1,24 @@
+// Steganography library - Part C (Generating Noise Images)
+
+// Description
+// Password seeded Gaussian noise is added to a 3-channel image.
+
+#ifndef STEGO_PART_C_H
+#define STEGO_PART_C_H
+
+#include <opencv2/core/core.hpp>
+#include "stego/common.h"
+#include "stego/noise.h"
+
+namespace stego {
+namespace part_c {
+
+// returns image with Gaussian noise of given sigma added
+cv::Mat_<cv::Vec3b> noise(const cv::Mat_<cv::Vec3b>& image, seed_t seed,
+                          double sigma = 10,
+                          noise_generator generator = noise_generator::chacha);
+
+}  // namespace part_c
+}  // namespace stego
+
+#endif  // STEGO_PART_C_H
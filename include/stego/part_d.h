@@ -0,0 +1,77 @@
+// Steganography library - Part D (Extending to Colour Images)
+
+// Description
+// Consecutive bits of binary message image are hidden within password seeded
+// randomly chosen bytes of a 3-channel carrier image.
+
+#ifndef STEGO_PART_D_H
+#define STEGO_PART_D_H
+
+#include <cstddef>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include "stego/bit_plane.h"
+#include "stego/common.h"
+
+namespace stego {
+namespace part_d {
+
+// order in which carrier bytes are chosen
+enum class order {
+    // random (row, col, channel) triples drawn until an unused byte lower
+    // than 255 is found; cost per bit grows as carrier fills up (images
+    // encoded before permutation order was introduced)
+    legacy,
+    // bytes lower than 255 partially shuffled once; constant cost per bit
+    permutation
+};
+
+// returns carrier with message hidden in it
+cv::Mat_<cv::Vec3b> encode(const cv::Mat_<cv::Vec3b>& carrier,
+                           const cv::Mat_<uchar>& message, seed_t seed,
+                           order slot_order = order::permutation);
+
+// returns message (0 or 255 pixels) recovered from encoded image
+cv::Mat_<uchar> decode(const cv::Mat_<cv::Vec3b>& carrier,
+                       const cv::Mat_<cv::Vec3b>& encoded, seed_t seed,
+                       order slot_order = order::permutation);
+
+// the same on packed message planes (white pixels are set bits)
+cv::Mat_<cv::Vec3b> encode(const cv::Mat_<cv::Vec3b>& carrier,
+                           const bit_plane& message, seed_t seed,
+                           order slot_order = order::permutation);
+bit_plane decode_bits(const cv::Mat_<cv::Vec3b>& carrier,
+                      const cv::Mat_<cv::Vec3b>& encoded, seed_t seed,
+                      order slot_order = order::permutation);
+
+// the same hiding message in carrier itself (replaced by a continuous copy
+// first when it is not continuous); no slot table is kept, bytes are
+// encoded as they are chosen
+void encode_in_place(cv::Mat_<cv::Vec3b>& carrier, const bit_plane& message,
+                     seed_t seed, order slot_order = order::permutation);
+
+// carrier image together with byte offsets of all of its bytes holding
+// message bits (in order of use); one prepared carrier serves any number of
+// encode/decode calls made with the same seed and order
+struct prepared_carrier {
+    cv::Mat_<cv::Vec3b> carrier;  // continuous
+    std::vector<std::size_t> slots;
+};
+
+prepared_carrier prepare(const cv::Mat_<cv::Vec3b>& carrier, seed_t seed,
+                         order slot_order = order::permutation);
+
+// the same operations on a prepared carrier
+cv::Mat_<cv::Vec3b> encode(const prepared_carrier& prepared,
+                           const cv::Mat_<uchar>& message);
+cv::Mat_<uchar> decode(const prepared_carrier& prepared,
+                       const cv::Mat_<cv::Vec3b>& encoded);
+cv::Mat_<cv::Vec3b> encode(const prepared_carrier& prepared,
+                           const bit_plane& message);
+bit_plane decode_bits(const prepared_carrier& prepared,
+                      const cv::Mat_<cv::Vec3b>& encoded);
+
+}  // namespace part_d
+}  // namespace stego
+
+#endif  // STEGO_PART_D_H
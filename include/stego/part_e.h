@@ -0,0 +1,210 @@
+// Steganography library - Part E (General Information Hiding)
+
+// Description
+// Bits of a file of any format are hidden within password seeded randomly
+// chosen bytes of noised 3-channel carrier image. The seed itself is hidden
+// first so that decoder is able to notice wrong password input. With LSB
+// embeddings bits are held by least significant bits of the bytes and
+// decoder needs the encoded image only (blind decoding). With permutation
+// order every byte (slot) may hold up to 4 bits, trading detectability for
+// capacity.
+
+#ifndef STEGO_PART_E_H
+#define STEGO_PART_E_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include "stego/buffer.h"
+#include "stego/chacha.h"
+#include "stego/common.h"
+#include "stego/compression.h"
+#include "stego/noise.h"
+
+namespace stego {
+namespace part_e {
+
+// sigma of Gaussian noise added to the carrier image
+constexpr double sigma = 5;
+
+// order in which free slots (noised carrier bytes lower than 255) are used
+enum class order {
+    // table of every free slot shuffled as a whole; cost depends on carrier
+    // size (images encoded before permutation order was introduced)
+    legacy,
+    // slots drawn lazily from a partial Fisher-Yates shuffle of all carrier
+    // bytes; cost depends on payload size only
+    permutation
+};
+
+// how bits change the bytes holding them
+enum class embedding {
+    // free slot incremented for 1 bits, decoder compares it with the noised
+    // carrier
+    additive,
+    // least significant bit of any byte matched to the bit by adding or
+    // subtracting 1 (at random)
+    lsb_matching,
+    // least significant bit of any byte overwritten with the bit
+    lsb_replacement
+};
+
+// encoder and decoder must be given the same options
+struct options {
+    order slot_order = order::permutation;  // LSB embeddings need permutation
+    noise_generator noise = noise_generator::chacha;
+    // message file size hidden as 64-bit (32-bit signed in legacy images)
+    bool wide_size = true;
+    embedding embed = embedding::additive;
+    // bits held by every slot, 1 to 4 (more than 1 needs permutation order);
+    // additive slots must then be at most 256 - 2^bits
+    int bits = 1;
+    // generator drawing slots
+    random_generator slot_generator = random_generator::chacha;
+    // versioned payload header (size, CRC32C checksum, algorithm) hidden
+    // after the seed, checked before the payload is read; images encoded
+    // before it was introduced hold the bare size
+    bool payload_header = true;
+    // compression of the payload before it is hidden (needs payload header,
+    // which records it, so decoders need not be given it)
+    compression compress = compression::none;
+
+    // options images were encoded with before any of them were introduced
+    static options legacy()
+    {
+        return {order::legacy, noise_generator::legacy, false,
+                embedding::additive, 1, random_generator::cv_rng, false,
+                compression::none};
+    }
+};
+
+// noised carrier image together with generator state right after noising
+// (cv::RNG slot generator only) and shuffled table of free slots (legacy
+// order only); one prepared carrier
+// serves any number of encode/decode calls made with the same seed and
+// options
+struct prepared_carrier {
+    cv::Mat_<cv::Vec3b> noised;  // continuous
+    cv::RNG rng;
+    seed_t seed;
+    options opts;
+    // legacy order only, byte offsets of free slots in order of use (64-bit
+    // offsets only for carriers over 4 GiB)
+    std::vector<std::uint32_t> slots;
+    std::vector<std::uint64_t> wide_slots;
+};
+
+prepared_carrier prepare(const cv::Mat_<cv::Vec3b>& carrier, seed_t seed,
+                         const options& opts = options());
+
+// the same noising carrier itself (replaced by a continuous copy first when
+// it is not continuous), so no second full-size image is allocated
+prepared_carrier prepare_in_place(cv::Mat_<cv::Vec3b>& carrier, seed_t seed,
+                                  const options& opts = options());
+
+// number of message file bytes the carrier can hold with the given seed and
+// options (free slots depend on noise, so on seed too); compressed files
+// may be bigger as long as their compressed size fits
+std::uint64_t capacity(const cv::Mat_<cv::Vec3b>& carrier, seed_t seed,
+                       const options& opts = options());
+std::uint64_t capacity(const prepared_carrier& prepared);
+
+// returns noised carrier with size bytes of data hidden in it
+cv::Mat_<cv::Vec3b> encode(const cv::Mat_<cv::Vec3b>& carrier,
+                           const char* data, std::size_t size, seed_t seed,
+                           const options& opts = options());
+
+// the same reading size bytes of file in fixed-size chunks, so memory use
+// does not depend on file size
+cv::Mat_<cv::Vec3b> encode(const cv::Mat_<cv::Vec3b>& carrier,
+                           std::istream& file, std::uint64_t size, seed_t seed,
+                           const options& opts = options());
+
+// returns file hidden in encoded image, throws stego::error on wrong password
+std::vector<char> decode(const cv::Mat_<cv::Vec3b>& carrier,
+                         const cv::Mat_<cv::Vec3b>& encoded, seed_t seed,
+                         const options& opts = options());
+
+// the same writing file in fixed-size chunks, returns file size; nothing
+// is written on wrong password, but the payload checksum is known only once
+// the whole file is read, so on checksum mismatch the corrupt file has
+// already been written when stego::error is thrown (callers remove it)
+std::uint64_t decode(const cv::Mat_<cv::Vec3b>& carrier,
+                     const cv::Mat_<cv::Vec3b>& encoded, std::ostream& file,
+                     seed_t seed, const options& opts = options());
+
+// blind decoding of images encoded with either LSB embedding (opts.embed is
+// not used), no carrier is needed
+std::vector<char> decode_blind(const cv::Mat_<cv::Vec3b>& encoded,
+                               seed_t seed, const options& opts = options());
+std::uint64_t decode_blind(const cv::Mat_<cv::Vec3b>& encoded,
+                           std::ostream& file, seed_t seed,
+                           const options& opts = options());
+
+// the same four operations on a prepared carrier (which is left unchanged)
+cv::Mat_<cv::Vec3b> encode(const prepared_carrier& prepared, const char* data,
+                           std::size_t size);
+cv::Mat_<cv::Vec3b> encode(const prepared_carrier& prepared,
+                           std::istream& file, std::uint64_t size);
+std::vector<char> decode(const prepared_carrier& prepared,
+                         const cv::Mat_<cv::Vec3b>& encoded);
+std::uint64_t decode(const prepared_carrier& prepared,
+                     const cv::Mat_<cv::Vec3b>& encoded, std::ostream& file);
+
+// encoding into the prepared noised carrier itself rather than into its
+// copy, for carriers prepared for one encoding (prepared is of no further
+// use afterwards)
+cv::Mat_<cv::Vec3b> encode_in_place(prepared_carrier& prepared,
+                                    const char* data, std::size_t size);
+cv::Mat_<cv::Vec3b> encode_in_place(prepared_carrier& prepared,
+                                    std::istream& file, std::uint64_t size);
+
+// in-memory operations over caller-owned 3-channel buffers (stego/buffer.h)
+// and payload spans; the carrier is noised straight into encoded, which may
+// be the carrier buffer itself (encoding in place), no image is copied; on
+// failure encoded is left noised (an in-place carrier is lost then)
+void encode(const pixel_view& carrier, const pixel_buffer& encoded,
+            const char* data, std::size_t size, seed_t seed,
+            const options& opts = options());
+
+// the hidden file is written to out, which must hold capacity bytes;
+// returns file size, throws stego::error when out is too small (before
+// writing anything, except for compressed files, whose size is known only
+// once they are decompressed); the noised carrier is the only image
+// allocated
+std::uint64_t decode(const pixel_view& carrier, const pixel_view& encoded,
+                     char* out, std::size_t capacity, seed_t seed,
+                     const options& opts = options());
+std::uint64_t decode_blind(const pixel_view& encoded, char* out,
+                           std::size_t capacity, seed_t seed,
+                           const options& opts = options());
+
+// tiled processing of raw images (stego/image_io.h) of any size: carrier is
+// read, noised, encoded and written a band of rows (about 4 MiB) at a time,
+// so memory use does not depend on image size; noise is the counter-based
+// noise of the whole image and every band draws its slots from its own
+// ChaCha stream, holding a share of the file in proportion to its rows (seed
+// and size go to the first band); images encoded this way are decoded with
+// decode_tiled only; needs permutation order, ChaCha slots and counter-based
+// noise, and does not compress; throws stego::error, with the size of the
+// largest file the carrier holds, when a band has too few free slots for its
+// share (before anything is hidden in it)
+void encode_tiled(const std::string& carrier_path, std::istream& file,
+                  std::uint64_t size, const std::string& encoded_path,
+                  seed_t seed, const options& opts = options());
+
+// returns file size; carrier_path is empty for blind decoding of LSB
+// embeddings (opts.embed is not used then); as with decode to a stream, the
+// file has been written when checksum mismatch is thrown
+std::uint64_t decode_tiled(const std::string& carrier_path,
+                           const std::string& encoded_path,
+                           std::ostream& file, seed_t seed,
+                           const options& opts = options());
+
+}  // namespace part_e
+}  // namespace stego
+
+#endif  // STEGO_PART_E_H
@@ -0,0 +1,63 @@
+// Steganography library - lazy permutation
+
+// Description
+// Fisher-Yates shuffle of [0, size) producing one element at a time. Only
+// swapped positions are remembered (in a hash map overlay over the identity
+// permutation), so both time and memory are proportional to the number of
+// elements taken, not to size. partial_shuffle samples a range in place.
+
+#ifndef STEGO_PERMUTATION_H
+#define STEGO_PERMUTATION_H
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <opencv2/core/core.hpp>
+#include "stego/chacha.h"
+
+namespace stego {
+
+class lazy_permutation {
+public:
+    // rng must outlive the permutation
+    lazy_permutation(std::uint64_t size, cv::RNG& rng);
+    lazy_permutation(std::uint64_t size, chacha_rng& rng);
+
+    // true when every element has been taken
+    bool empty() const { return position_ == size_; }
+
+    // next element of the permutation, must not be called when empty()
+    std::uint64_t next();
+
+private:
+    std::uint64_t value_at(std::uint64_t index) const;
+
+    std::uint64_t size_;
+    std::uint64_t position_ = 0;
+    cv::RNG* rng_ = nullptr;  // one of the two generators is used
+    chacha_rng* chacha_ = nullptr;
+    std::unordered_map<std::uint64_t, std::uint64_t> swapped_;
+};
+
+// uniformly distributed integer from [0, n), n > 0
+std::uint64_t uniform(cv::RNG& rng, std::uint64_t n);
+std::uint64_t uniform(chacha_rng& rng, std::uint64_t n);
+
+// Fisher-Yates shuffle stopped after (middle - first) steps: [first, middle)
+// receives a random sample of [first, last) in random order, the rest of the
+// range is left in unspecified order; cost depends on the sample size only
+// (ranges over 2^32 elements draw 64-bit indices)
+template <typename RandomIt, typename Generator>
+void partial_shuffle(RandomIt first, RandomIt middle, RandomIt last,
+                     Generator& rng)
+{
+    for (auto i = first; i != middle; ++i) {
+        auto j = i + uniform(rng, std::uint64_t(last - i));
+        if (i != j)
+            std::iter_swap(i, j);
+    }
+}
+
+}  // namespace stego
+
+#endif  // STEGO_PERMUTATION_H
@@ -0,0 +1,107 @@
+// Steganography library - instrumentation
+
+// Description
+// Stages of the programs (loading, noising, embedding, saving...) are timed
+// and reported as human readable text ("Loading carrier image (a.png)...
+// done (1.2 ms)"), as JSON lines (one object per stage and a summary object)
+// or not at all. The library keeps process-wide counters of its work (slots
+// scanned, rejected random picks, bytes read and written), which are
+// reported in the summary together with the peak resident set size.
+
+#ifndef STEGO_REPORT_H
+#define STEGO_REPORT_H
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+namespace stego {
+
+enum class counter {
+    slots_scanned,  // carrier bytes examined while choosing slots
+    retries,        // random picks rejected (legacy part D order)
+    bytes_read,     // image and message file bytes
+    bytes_written
+};
+constexpr int counter_count = 4;
+
+// adds n to counter (relaxed atomic, callers add once per call rather than
+// once per byte)
+void add(counter which, std::uint64_t n = 1);
+std::uint64_t value(counter which);
+const char* name(counter which);
+void reset_counters();
+
+// peak resident set size of the process in bytes (0 where unknown)
+std::uint64_t peak_rss();
+
+enum class report_format {
+    text,
+    json,  // JSON lines
+    quiet  // failures only (to std::cerr)
+};
+
+// "text", "json" or "quiet", throws stego::error on anything else
+report_format parse_report_format(const std::string& text);
+
+// JSON string literal of text (quoted and escaped)
+std::string json_string(const std::string& text);
+
+class report {
+public:
+    // stage timer, reported when done or failed (or as failed when left
+    // unfinished)
+    class stage {
+    public:
+        stage(stage&& other) noexcept;
+        stage& operator=(stage&& other) noexcept;
+        ~stage();
+
+        // detail (e.g. "1024 bits") is appended to the report
+        void done(const std::string& detail = "");
+        void fail(const std::string& message);
+
+    private:
+        friend class report;
+        stage(report* owner, std::string name, std::string subject);
+        void finish(bool ok, const std::string& detail);
+
+        report* owner_;
+        std::string name_;
+        std::string subject_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    explicit report(report_format format = report_format::text,
+                    std::ostream& out = std::cout);
+
+    // starts a stage named e.g. "Loading carrier image" of subject (a path,
+    // optional); on text output the name is printed right away; output is
+    // flushed by failures, prompts and the summary only, not by every stage
+    stage begin(const std::string& name, const std::string& subject = "");
+
+    // reports a stage timed elsewhere (e.g. a batch job)
+    void record(const std::string& name, const std::string& subject, bool ok,
+                double milliseconds, const std::string& detail = "");
+
+    // failure outside of any stage
+    void fail(const std::string& message);
+
+    // prompt for interactive input, shown on text output only
+    void prompt(const std::string& text);
+
+    // total time since construction, peak memory and counters
+    void summary();
+
+    report_format format() const { return format_; }
+
+private:
+    report_format format_;
+    std::ostream& out_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace stego
+
+#endif  // STEGO_REPORT_H
@@ -0,0 +1,34 @@
+// Steganography library - free slots
+
+// Description
+// A free slot is a byte of 3-channel image lower than 255, i.e. one which can
+// be incremented to hold a bit. Slots are addressed with linear byte offsets
+// into the continuous image buffer; 32-bit offsets are enough for images up
+// to 4 GiB and take a third of the memory of (row, col, channel) triples.
+// Bands of rows are scanned in parallel, 64 bytes at a time: free bytes are
+// turned into a bit mask (SSE2 compares on x86-64) and the offsets of its set
+// bits are stored at the band position given by prefix sums of band counts.
+
+#ifndef STEGO_SLOTS_H
+#define STEGO_SLOTS_H
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+namespace stego {
+
+// true when offsets of every byte of image fit in 32 bits
+inline bool fits_32bit_slots(const cv::Mat_<cv::Vec3b>& image)
+{
+    return image.total() * 3 <= UINT32_MAX;
+}
+
+// byte offsets of all free slots of image in row-major, channel order
+// (Index is std::uint32_t or std::uint64_t)
+template <typename Index>
+std::vector<Index> free_slots(const cv::Mat_<cv::Vec3b>& image);
+
+}  // namespace stego
+
+#endif  // STEGO_SLOTS_H
@@ -0,0 +1,30 @@
+// Steganography library
+
+// Description
+// Hiding information in images using C++ and OpenCV. Every part of the
+// practical is available as a pair of encode/decode functions (see README).
+
+#ifndef STEGO_STEGO_H
+#define STEGO_STEGO_H
+
+#include "stego/batch.h"
+#include "stego/bit_plane.h"
+#include "stego/buffer.h"
+#include "stego/carrier_cache.h"
+#include "stego/chacha.h"
+#include "stego/common.h"
+#include "stego/compression.h"
+#include "stego/image_io.h"
+#include "stego/key.h"
+#include "stego/lru_cache.h"
+#include "stego/noise.h"
+#include "stego/part_a.h"
+#include "stego/part_b.h"
+#include "stego/part_c.h"
+#include "stego/part_d.h"
+#include "stego/part_e.h"
+#include "stego/permutation.h"
+#include "stego/report.h"
+#include "stego/slots.h"
+
+#endif  // STEGO_STEGO_H
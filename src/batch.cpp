@@ -0,0 +1,497 @@
+// Steganography library - batch processing
+
+#include "stego/batch.h"
+#include "stego/bit_plane.h"
+#include "stego/carrier_cache.h"
+#include "stego/image_io.h"
+#include "stego/lru_cache.h"
+#include "stego/part_b.h"
+#include "stego/part_d.h"
+#include "stego/part_e.h"
+#include <opencv2/highgui/highgui.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace cv;
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace stego {
+namespace batch {
+
+namespace {
+
+const char* const tool_names[] = {"b_encoder", "b_decoder", "d_encoder",
+                                  "d_decoder", "e_encoder", "e_decoder"};
+
+using fields = map<string, string>;
+
+error manifest_error(size_t line, const string& what)
+{
+    return error("Manifest line " + to_string(line) + ": " + what);
+}
+
+// splits CSV line, fields may be double-quoted ("" stands for a quote)
+vector<string> split_csv(const string& line)
+{
+    vector<string> values(1);
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); ++i) {
+        auto c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"')
+                values.back() += line[++i];
+            else if (c == '"')
+                quoted = false;
+            else
+                values.back() += c;
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            values.emplace_back();
+        } else if (c != '\r') {
+            values.back() += c;
+        }
+    }
+    return values;
+}
+
+// parses flat JSON object with string, number and boolean values
+fields parse_json(const string& line, size_t line_number)
+{
+    fields object;
+    size_t i = 0;
+    auto skip_spaces = [&] {
+        while (i < line.size() && isspace((unsigned char)line[i]))
+            ++i;
+    };
+    auto expect = [&](char c) {
+        skip_spaces();
+        if (i == line.size() || line[i] != c)
+            throw manifest_error(line_number, string("expected '") + c + "'");
+        ++i;
+    };
+    auto read_string = [&] {
+        expect('"');
+        string value;
+        while (i < line.size() && line[i] != '"') {
+            auto c = line[i++];
+            if (c == '\\' && i < line.size()) {
+                c = line[i++];
+                switch (c) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'r': c = '\r'; break;
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'u': {
+                    if (i + 4 > line.size() ||
+                        !all_of(line.begin() + i, line.begin() + i + 4,
+                                [](char digit) {
+                                    return isxdigit((unsigned char)digit);
+                                }))
+                        throw manifest_error(line_number, "bad escape");
+                    auto code = stoul(line.substr(i, 4), nullptr, 16);
+                    i += 4;
+                    if (code < 0x80) {
+                        c = char(code);
+                    } else if (code < 0x800) {
+                        value += char(0xC0 | code >> 6);
+                        c = char(0x80 | (code & 0x3F));
+                    } else {
+                        value += char(0xE0 | code >> 12);
+                        value += char(0x80 | (code >> 6 & 0x3F));
+                        c = char(0x80 | (code & 0x3F));
+                    }
+                    break;
+                }
+                default: break;  // \" \\ and \/ stand for themselves
+                }
+            }
+            value += c;
+        }
+        expect('"');
+        return value;
+    };
+
+    expect('{');
+    skip_spaces();
+    if (i < line.size() && line[i] == '}')
+        return object;
+    for (;;) {
+        auto key = read_string();
+        expect(':');
+        skip_spaces();
+        if (i < line.size() && line[i] == '"') {
+            object[key] = read_string();
+        } else {
+            auto start = i;
+            while (i < line.size() && line[i] != ',' && line[i] != '}' &&
+                   !isspace((unsigned char)line[i]))
+                ++i;
+            object[key] = line.substr(start, i - start);
+        }
+        skip_spaces();
+        if (i < line.size() && line[i] == ',') {
+            ++i;
+            continue;
+        }
+        expect('}');
+        return object;
+    }
+}
+
+bool parse_bool(const string& value, size_t line)
+{
+    if (value.empty() || value == "0" || value == "false")
+        return false;
+    if (value == "1" || value == "true")
+        return true;
+    throw manifest_error(line, "expected true or false, got " + value);
+}
+
+// passwords read from password sources, each source read once (a file
+// descriptor gives its line only once)
+using password_sources = map<string, string>;
+
+job make_job(const fields& values, size_t line, password_sources& sources)
+{
+    // empty values (e.g. empty CSV cells) count as missing
+    auto get = [&](const char* name, bool required) -> const string* {
+        auto it = values.find(name);
+        if (it == values.end() || it->second.empty()) {
+            if (required)
+                throw manifest_error(line, string("missing ") + name);
+            return nullptr;
+        }
+        return &it->second;
+    };
+
+    job task;
+    task.line = line;
+    auto program = *get("tool", true);
+    auto name = find(begin(tool_names), end(tool_names), program);
+    if (name == end(tool_names))
+        throw manifest_error(line, "unknown tool " + program);
+    task.program = tool(name - begin(tool_names));
+    if (auto blind = get("blind", false))
+        task.blind = parse_bool(*blind, line);
+    if (task.blind && task.program != tool::e_encoder &&
+        task.program != tool::e_decoder)
+        throw manifest_error(line, "blind is supported by part E only");
+    // blind decoding needs no carrier
+    auto carrier = get("carrier", !(task.blind &&
+                                    task.program == tool::e_decoder));
+    if (carrier)
+        task.carrier = *carrier;
+    task.input = *get("input", true);
+    task.output = *get("output", true);
+    if (auto password = get("password", false)) {
+        task.has_password = true;
+        task.password = *password;
+    }
+    if (auto source = get("password_source", false)) {
+        if (task.has_password)
+            throw manifest_error(line,
+                                 "both password and password_source given");
+        auto known = sources.find(*source);
+        if (known == sources.end()) {
+            try {
+                known = sources.emplace(*source, read_password(*source)).first;
+            } catch (const error& e) {
+                throw manifest_error(line, e.what());
+            }
+        }
+        task.has_password = true;
+        task.password = known->second;
+    }
+    if (auto legacy = get("legacy", false))
+        task.legacy = parse_bool(*legacy, line);
+    if (auto bits = get("bits", false)) {
+        if (bits->size() != 1 || (*bits)[0] < '1' || (*bits)[0] > '4')
+            throw manifest_error(line, "expected bits 1 to 4, got " + *bits);
+        if (task.program != tool::e_encoder &&
+            task.program != tool::e_decoder)
+            throw manifest_error(line, "bits is supported by part E only");
+        task.bits = (*bits)[0] - '0';
+    }
+    if (auto header = get("header", false)) {
+        if (task.program != tool::e_encoder &&
+            task.program != tool::e_decoder)
+            throw manifest_error(line, "header is supported by part E only");
+        task.header = parse_bool(*header, line);
+    }
+    if (auto compress = get("compress", false)) {
+        if (task.program != tool::e_encoder)
+            throw manifest_error(line, "compress is supported by e_encoder "
+                                       "only");
+        try {
+            task.compress = parse_compression(*compress);
+        } catch (const error& e) {
+            throw manifest_error(line, e.what());
+        }
+    }
+    if (auto key = get("key", false)) {
+        try {
+            task.key = key_params::parse(*key);
+        } catch (const error& e) {
+            throw manifest_error(line, e.what());
+        }
+    } else if (task.legacy) {
+        task.key = key_params::legacy();
+    }
+    if (auto rng = get("rng", false)) {
+        if (task.program != tool::e_encoder &&
+            task.program != tool::e_decoder)
+            throw manifest_error(line, "rng is supported by part E only");
+        if (*rng != "cv" && *rng != "chacha")
+            throw manifest_error(line, "expected rng cv or chacha, got " +
+                                           *rng);
+        task.cv_rng = *rng == "cv";
+    }
+    return task;
+}
+
+image_file load(const string& path, int flags)
+{
+    auto loaded = image_file(path, flags);
+    if (!loaded.image().data)
+        throw error("Could not open or find " + path);
+    return loaded;
+}
+
+// message images are packed as soon as they are loaded
+bit_plane message(const string& path)
+{
+    return bit_plane::from_image(load(path, IMREAD_GRAYSCALE).image());
+}
+
+part_e::options e_options(const job& task)
+{
+    auto options = task.legacy ? part_e::options::legacy()
+                               : part_e::options();
+    if (task.blind)
+        options.embed = part_e::embedding::lsb_matching;
+    options.bits = task.bits;
+    options.payload_header = options.payload_header && task.header;
+    options.compress = task.compress;
+    // images encoded before ChaCha generators were introduced (legacy
+    // options use cv::RNG already)
+    if (task.cv_rng && !task.legacy) {
+        options.noise = noise_generator::counter;
+        options.slot_generator = random_generator::cv_rng;
+    }
+    return options;
+}
+
+}  // namespace
+
+runner::runner(const settings& config)
+    : config_(config),
+      images_(config.cache_bytes / 2),
+      prepared_(config.cache_bytes / 2, config.cache_directory)
+{
+}
+
+result runner::run(const job& task)
+{
+    result outcome;
+    outcome.line = task.line;
+    auto start = chrono::steady_clock::now();
+    try {
+        execute(task);
+        outcome.ok = true;
+    } catch (const std::exception& e) {
+        outcome.message = e.what();
+    }
+    outcome.milliseconds = chrono::duration<double, milli>(
+                               chrono::steady_clock::now() - start)
+                               .count();
+    return outcome;
+}
+
+void runner::execute(const job& task)
+{
+    // jobs sharing password and key derivation derive their seed once
+    auto seed = keys_.derive(
+        task.has_password ? task.password : config_.password, task.key);
+    switch (task.program) {
+    case tool::b_encoder:
+        save(task.output,
+             part_b::encode(image(task.carrier, IMREAD_GRAYSCALE),
+                            message(task.input), seed));
+        break;
+    case tool::b_decoder:
+        save(task.output,
+             part_b::decode_bits(image(task.carrier, IMREAD_GRAYSCALE),
+                                 load(task.input, IMREAD_GRAYSCALE).image(),
+                                 seed)
+                 .to_image());
+        break;
+    case tool::d_encoder:
+        save(task.output,
+             part_d::encode(*prepared_d(task, seed), message(task.input)));
+        break;
+    case tool::d_decoder:
+        save(task.output,
+             part_d::decode_bits(*prepared_d(task, seed),
+                                 load(task.input, IMREAD_COLOR).image())
+                 .to_image());
+        break;
+    case tool::e_encoder: {
+        auto file = ifstream(task.input, ios::binary | ios::ate);
+        if (!file.is_open())
+            throw error("Could not open or find " + task.input);
+        auto file_size = uint64_t(file.tellg());
+        file.seekg(0, ios::beg);
+        save(task.output,
+             part_e::encode(*prepared_e(task, seed), file, file_size));
+        break;
+    }
+    case tool::e_decoder: {
+        auto encoded_file = load(task.input, IMREAD_COLOR);
+        auto encoded = Mat_<Vec3b>(encoded_file.image());
+        auto carrier = task.blind ? nullptr : prepared_e(task, seed);
+        auto file = ofstream(task.output, ios::binary | ios::trunc);
+        if (!file.is_open())
+            throw error("Could not open or find " + task.output);
+        try {
+            if (carrier)
+                part_e::decode(*carrier, encoded, file);
+            else
+                part_e::decode_blind(encoded, file, seed, e_options(task));
+        } catch (...) {
+            file.close();
+            remove(task.output.c_str());  // not producing invalid file
+            throw;
+        }
+        break;
+    }
+    }
+}
+
+void runner::save(const string& path, const Mat& image) const
+{
+    if (!write_image(path, image, config_.png_level))
+        throw error("Could not save " + path);
+}
+
+// decoded carrier images are shared by jobs; files changed since they were
+// cached (size or modification time) are loaded again
+Mat runner::image(const string& path, int flags)
+{
+    error_code size_failed, time_failed;
+    auto size = fs::file_size(path, size_failed);
+    auto modified = fs::last_write_time(path, time_failed);
+    auto key = image_key(
+        path, flags, size_failed ? 0 : size,
+        time_failed ? 0 : int64_t(modified.time_since_epoch().count()));
+    if (auto cached = images_.find(key))
+        return *cached;
+    // mapped raw images are copied, files are not kept open
+    auto file = load(path, flags);
+    auto loaded = make_shared<const Mat>(
+        file.mapped() ? file.image().clone() : file.image());
+    images_.insert(key, loaded, loaded->total() * loaded->elemSize());
+    return *loaded;
+}
+
+// so are prepared carriers of parts D and E (per password)
+shared_ptr<const part_d::prepared_carrier> runner::prepared_d(
+    const job& task, seed_t seed)
+{
+    auto slot_order = task.legacy ? part_d::order::legacy
+                                  : part_d::order::permutation;
+    return prepared_.prepare_d(image(task.carrier, IMREAD_COLOR), seed,
+                               slot_order);
+}
+
+shared_ptr<const part_e::prepared_carrier> runner::prepared_e(
+    const job& task, seed_t seed)
+{
+    return prepared_.prepare_e(image(task.carrier, IMREAD_COLOR), seed,
+                               e_options(task));
+}
+
+vector<job> read_manifest(istream& manifest)
+{
+    vector<job> jobs;
+    password_sources sources;
+    vector<string> header;
+    string line;
+    size_t line_number = 0;
+    while (getline(manifest, line)) {
+        ++line_number;
+        auto first = line.find_first_not_of(" \t\r");
+        if (first == string::npos || line[first] == '#')
+            continue;  // empty lines and comments
+        if (line[first] == '{') {
+            auto values = parse_json(line, line_number);
+            jobs.push_back(make_job(values, line_number, sources));
+            continue;
+        }
+        auto values = split_csv(line);
+        if (header.empty()) {
+            header = values;
+            continue;
+        }
+        if (values.size() > header.size())
+            throw manifest_error(line_number, "too many columns");
+        fields row;
+        for (size_t i = 0; i < values.size(); ++i)
+            row[header[i]] = values[i];
+        jobs.push_back(make_job(row, line_number, sources));
+    }
+    return jobs;
+}
+
+job parse_job(const string& line, size_t line_number)
+{
+    auto values = parse_json(line, line_number);
+    if (values.count("password_source"))
+        throw manifest_error(line_number, "password_source is not accepted "
+                                          "in requests");
+    password_sources sources;
+    return make_job(values, line_number, sources);
+}
+
+void run(const vector<job>& jobs, const settings& config,
+         const function<void(const job&, const result&)>& report)
+{
+    runner shared(config);
+    atomic<size_t> next(0);
+    mutex report_mutex;
+    auto worker = [&] {
+        for (size_t i; (i = next++) < jobs.size();) {
+            auto outcome = shared.run(jobs[i]);
+            lock_guard<mutex> lock(report_mutex);
+            report(jobs[i], outcome);
+        }
+    };
+
+    auto threads = config.threads ? config.threads
+                                  : max(1u, thread::hardware_concurrency());
+    vector<thread> pool;
+    for (unsigned i = 1; i < min<size_t>(threads, jobs.size()); ++i)
+        pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool)
+        t.join();
+}
+
+const char* tool_name(tool program)
+{
+    return tool_names[int(program)];
+}
+
+}  // namespace batch
+}  // namespace stego
@@ -0,0 +1,56 @@
+// Steganography library - bit planes
+
+#include "stego/bit_plane.h"
+#include <algorithm>
+
+using namespace cv;
+using namespace std;
+
+namespace stego {
+
+bit_plane::bit_plane(int rows, int cols)
+    : rows_(rows),
+      cols_(cols),
+      words_per_row_((size_t(cols) + 63) / 64),
+      words_(size_t(rows) * words_per_row_)
+{
+}
+
+bit_plane bit_plane::from_image(const Mat_<uchar>& image)
+{
+    bit_plane plane(image.rows, image.cols);
+    for (int r = 0; r < image.rows; ++r) {
+        auto pixels = image[r];
+        auto words = plane.row(r);
+        for (int first = 0; first < image.cols; first += 64) {
+            auto count = min(64, image.cols - first);
+            uint64_t word = 0;
+            for (int i = 0; i < count; ++i)
+                word |= uint64_t(pixels[first + i] != 0) << i;
+            words[first / 64] = word;
+        }
+    }
+    return plane;
+}
+
+Mat_<uchar> bit_plane::to_image() const
+{
+    Mat_<uchar> image(rows_, cols_);
+    for (int r = 0; r < rows_; ++r) {
+        auto pixels = image[r];
+        auto words = row(r);
+        for (int c = 0; c < cols_; ++c)
+            pixels[c] = (words[c / 64] >> (c % 64) & 1) ? 255 : 0;
+    }
+    return image;
+}
+
+size_t bit_plane::count() const
+{
+    size_t white = 0;
+    for (auto word : words_)
+        white += popcount(word);
+    return white;
+}
+
+}  // namespace stego
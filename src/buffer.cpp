@@ -0,0 +1,30 @@
+// Steganography library - caller-owned buffers
+
+#include "stego/buffer.h"
+#include "stego/common.h"
+
+using namespace cv;
+using namespace std;
+
+namespace stego {
+
+Mat wrap(const pixel_view& view)
+{
+    if (!view.data || view.rows <= 0 || view.cols <= 0)
+        throw error("Empty pixel buffer");
+    if (view.channels != 1 && view.channels != 3)
+        throw error("Pixel buffers must be of 1 or 3 channels");
+    auto row_bytes = size_t(view.cols) * view.channels;
+    auto stride = view.stride ? view.stride : row_bytes;
+    if (stride < row_bytes)
+        throw error("Pixel buffer stride is shorter than a row");
+    return Mat(view.rows, view.cols, view.channels == 1 ? CV_8UC1 : CV_8UC3,
+               const_cast<unsigned char*>(view.data), stride);
+}
+
+Mat wrap(const pixel_buffer& buffer)
+{
+    return wrap(pixel_view(buffer));
+}
+
+}  // namespace stego
@@ -0,0 +1,311 @@
+// Steganography library - prepared carrier cache
+
+#include "stego/carrier_cache.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <vector>
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+using namespace cv;
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace stego {
+
+namespace {
+
+const char magic[8] = {'S', 'T', 'E', 'G', 'O', 'P', 'C', '2'};
+const char* const extension = ".stegocache";
+
+enum part { part_d_carrier = 0, part_e_carrier = 1 };
+
+template <typename T>
+void write_value(ostream& out, const T& value)
+{
+    out.write((const char*)&value, sizeof(T));
+}
+
+template <typename T>
+bool read_value(istream& in, T& value)
+{
+    return bool(in.read((char*)&value, sizeof(T)));
+}
+
+template <typename T>
+void write_vector(ostream& out, const vector<T>& values)
+{
+    write_value(out, uint64_t(values.size()));
+    out.write((const char*)values.data(), values.size() * sizeof(T));
+}
+
+template <typename T>
+bool read_vector(istream& in, vector<T>& values, uint64_t max_size)
+{
+    uint64_t size;
+    if (!read_value(in, size) || size > max_size)
+        return false;
+    values.resize(size_t(size));
+    return bool(in.read((char*)values.data(), values.size() * sizeof(T)));
+}
+
+// bytes taken by prepared carriers (carrier image of part D is shared with
+// the caller, so it is not counted)
+size_t cost(const part_d::prepared_carrier& prepared)
+{
+    return prepared.slots.size() * sizeof(size_t);
+}
+
+size_t cost(const part_e::prepared_carrier& prepared)
+{
+    return prepared.noised.total() * 3 +
+           prepared.slots.size() * sizeof(uint32_t) +
+           prepared.wide_slots.size() * sizeof(uint64_t);
+}
+
+int variant(const part_e::options& opts)
+{
+    // size field width and bits per slot do not change prepared carrier;
+    // mixed radix digits: generator (2), embedding (3), order (2), noise (3)
+    auto value = int(opts.slot_generator);
+    value = value * 3 + int(opts.embed);
+    value = value * 2 + int(opts.slot_order);
+    return value * 3 + int(opts.noise);
+}
+
+}  // namespace
+
+uint64_t content_hash(const Mat& image)
+{
+    auto hash = mix64(uint64_t(image.rows) << 32 | uint32_t(image.cols)) ^
+                mix64(uint64_t(image.type()) + 1);
+    auto row_bytes = size_t(image.cols) * image.elemSize();
+    for (int row = 0; row < image.rows; ++row) {
+        auto bytes = image.ptr<uchar>(row);
+        size_t i = 0;
+        for (; i + 8 <= row_bytes; i += 8) {
+            uint64_t word;
+            memcpy(&word, bytes + i, 8);
+            hash = (hash ^ mix64(word)) * 0x9E3779B97F4A7C15;
+        }
+        uint64_t tail = 0;
+        memcpy(&tail, bytes + i, row_bytes - i);
+        hash = (hash ^ mix64(tail ^ (uint64_t(row) << 3))) * 0x9E3779B97F4A7C15;
+    }
+    return mix64(hash);
+}
+
+carrier_cache::carrier_cache(size_t memory_bytes, string directory,
+                             uint64_t disk_bytes)
+    : memory_(memory_bytes),
+      directory_(move(directory)),
+      disk_bytes_(disk_bytes)
+{
+    if (!directory_.empty()) {
+        error_code ignored;
+        fs::create_directories(directory_, ignored);
+    }
+}
+
+shared_ptr<const part_d::prepared_carrier> carrier_cache::prepare_d(
+    const Mat_<Vec3b>& carrier, seed_t seed, part_d::order slot_order)
+{
+    auto k = key(content_hash(carrier), seed, part_d_carrier, int(slot_order));
+    if (auto cached = memory_.find(k))
+        return cached->d;
+
+    auto found = make_shared<entry>();
+    if (!load(k, carrier, *found)) {
+        found->d = make_shared<const part_d::prepared_carrier>(
+            part_d::prepare(carrier, seed, slot_order));
+        store(k, *found);
+    }
+    memory_.insert(k, found, cost(*found->d));
+    return found->d;
+}
+
+shared_ptr<const part_e::prepared_carrier> carrier_cache::prepare_e(
+    const Mat_<Vec3b>& carrier, seed_t seed, const part_e::options& opts)
+{
+    auto k = key(content_hash(carrier), seed, part_e_carrier, variant(opts));
+    auto matching = [&](shared_ptr<const part_e::prepared_carrier> prepared) {
+        if (prepared->opts.wide_size == opts.wide_size &&
+            prepared->opts.bits == opts.bits &&
+            prepared->opts.payload_header == opts.payload_header &&
+            prepared->opts.compress == opts.compress)
+            return prepared;
+        auto copy = make_shared<part_e::prepared_carrier>(*prepared);
+        copy->opts.wide_size = opts.wide_size;
+        copy->opts.bits = opts.bits;
+        copy->opts.payload_header = opts.payload_header;
+        copy->opts.compress = opts.compress;
+        return shared_ptr<const part_e::prepared_carrier>(copy);
+    };
+    if (auto cached = memory_.find(k))
+        return matching(cached->e);
+
+    auto found = make_shared<entry>();
+    if (!load(k, carrier, *found)) {
+        found->e = make_shared<const part_e::prepared_carrier>(
+            part_e::prepare(carrier, seed, opts));
+        store(k, *found);
+    }
+    memory_.insert(k, found, cost(*found->e));
+    return matching(found->e);
+}
+
+string carrier_cache::file_name(const key& k) const
+{
+    // seed is not stored in plain in file names
+    auto name = mix64(get<0>(k) ^
+                      mix64(get<1>(k) ^ mix64(get<2>(k) * 64 + get<3>(k))));
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)name);
+    return (fs::path(directory_) / (string(hex) + extension)).string();
+}
+
+bool carrier_cache::load(const key& k, const Mat_<Vec3b>& carrier,
+                         entry& found) const
+{
+    if (directory_.empty())
+        return false;
+    auto path = file_name(k);
+    auto in = ifstream(path, ios::binary);
+    if (!in.is_open())
+        return false;
+
+    char file_magic[sizeof(magic)];
+    int32_t file_part, file_variant, rows, cols;
+    uint64_t content, seed_check;
+    if (!in.read(file_magic, sizeof(file_magic)) ||
+        memcmp(file_magic, magic, sizeof(magic)) != 0 ||
+        !read_value(in, file_part) || !read_value(in, file_variant) ||
+        !read_value(in, content) || !read_value(in, seed_check) ||
+        !read_value(in, rows) || !read_value(in, cols))
+        return false;
+    if (file_part != get<2>(k) || file_variant != get<3>(k) ||
+        content != get<0>(k) || seed_check != mix64(get<1>(k)) ||
+        rows != carrier.rows || cols != carrier.cols)
+        return false;
+
+    auto bytes = uint64_t(rows) * cols * 3;
+    if (file_part == part_d_carrier) {
+        auto prepared = make_shared<part_d::prepared_carrier>();
+        prepared->carrier =
+            carrier.isContinuous() ? carrier : carrier.clone();
+        if (!read_vector(in, prepared->slots, bytes))
+            return false;
+        found.d = prepared;
+    } else {
+        auto prepared = make_shared<part_e::prepared_carrier>();
+        prepared->seed = get<1>(k);
+        prepared->opts.slot_generator = random_generator(file_variant / 18);
+        prepared->opts.embed = part_e::embedding(file_variant / 6 % 3);
+        prepared->opts.slot_order = part_e::order(file_variant / 3 % 2);
+        prepared->opts.noise = noise_generator(file_variant % 3);
+        prepared->noised.create(rows, cols);
+        if (!read_value(in, prepared->rng.state) ||
+            !in.read((char*)prepared->noised.data, bytes) ||
+            !read_vector(in, prepared->slots, bytes) ||
+            !read_vector(in, prepared->wide_slots, bytes))
+            return false;
+        found.e = prepared;
+    }
+
+    // marking file as recently used
+    error_code ignored;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ignored);
+    return true;
+}
+
+void carrier_cache::store(const key& k, const entry& prepared) const
+{
+    if (directory_.empty())
+        return;
+    auto path = file_name(k);
+    // unique among processes sharing the directory and threads of this one
+    static atomic<uint64_t> stores(0);
+    auto temporary = path + ".tmp" + to_string(getpid()) + "_" +
+                     to_string(stores++);
+    {
+        auto out = ofstream(temporary, ios::binary | ios::trunc);
+        if (!out.is_open())
+            return;  // cache directory is best effort only
+        out.write(magic, sizeof(magic));
+        write_value(out, int32_t(get<2>(k)));
+        write_value(out, int32_t(get<3>(k)));
+        write_value(out, get<0>(k));
+        write_value(out, mix64(get<1>(k)));
+        if (prepared.d) {
+            write_value(out, int32_t(prepared.d->carrier.rows));
+            write_value(out, int32_t(prepared.d->carrier.cols));
+            write_vector(out, prepared.d->slots);
+        } else {
+            const auto& noised = prepared.e->noised;
+            write_value(out, int32_t(noised.rows));
+            write_value(out, int32_t(noised.cols));
+            write_value(out, prepared.e->rng.state);
+            out.write((const char*)noised.data, noised.total() * 3);
+            write_vector(out, prepared.e->slots);
+            write_vector(out, prepared.e->wide_slots);
+        }
+        if (!out) {
+            out.close();
+            remove(temporary.c_str());
+            return;
+        }
+    }
+    // renaming is atomic, so other processes never see partial files
+    error_code failed;
+    fs::rename(temporary, path, failed);
+    if (failed)
+        remove(temporary.c_str());
+    trim_directory();
+}
+
+void carrier_cache::trim_directory() const
+{
+    if (!disk_bytes_)
+        return;
+    struct cache_file {
+        fs::path path;
+        uint64_t size;
+        fs::file_time_type used;
+    };
+    vector<cache_file> files;
+    uint64_t total = 0;
+    error_code failed;
+    for (fs::directory_iterator it(directory_, failed), end;
+         !failed && it != end; it.increment(failed)) {
+        if (it->path().extension() != extension)
+            continue;
+        error_code ignored;
+        auto size = fs::file_size(it->path(), ignored);
+        auto used = fs::last_write_time(it->path(), ignored);
+        files.push_back({it->path(), size, used});
+        total += size;
+    }
+    // least recently used files are deleted first
+    sort(files.begin(), files.end(),
+         [](const cache_file& a, const cache_file& b) {
+             return a.used < b.used;
+         });
+    for (const auto& file : files) {
+        if (total <= disk_bytes_)
+            break;
+        error_code ignored;
+        if (fs::remove(file.path, ignored))
+            total -= file.size;
+    }
+}
+
+}  // namespace stego
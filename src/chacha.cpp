@@ -0,0 +1,82 @@
+// Steganography library - stream cipher generator
+
+#include "stego/chacha.h"
+
+namespace stego {
+
+namespace {
+
+inline std::uint32_t rotl(std::uint32_t x, int n)
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+inline void quarter_round(std::uint32_t& a, std::uint32_t& b,
+                          std::uint32_t& c, std::uint32_t& d)
+{
+    a += b;
+    d = rotl(d ^ a, 16);
+    c += d;
+    b = rotl(b ^ c, 12);
+    a += b;
+    d = rotl(d ^ a, 8);
+    c += d;
+    b = rotl(b ^ c, 7);
+}
+
+}  // namespace
+
+void chacha_core(const std::uint32_t in[16], std::uint32_t out[16],
+                 int rounds)
+{
+    std::uint32_t x[16];
+    for (int i = 0; i < 16; ++i)
+        x[i] = in[i];
+    for (int round = 0; round < rounds; round += 2) {
+        // column round
+        quarter_round(x[0], x[4], x[8], x[12]);
+        quarter_round(x[1], x[5], x[9], x[13]);
+        quarter_round(x[2], x[6], x[10], x[14]);
+        quarter_round(x[3], x[7], x[11], x[15]);
+        // diagonal round
+        quarter_round(x[0], x[5], x[10], x[15]);
+        quarter_round(x[1], x[6], x[11], x[12]);
+        quarter_round(x[2], x[7], x[8], x[13]);
+        quarter_round(x[3], x[4], x[9], x[14]);
+    }
+    for (int i = 0; i < 16; ++i)
+        out[i] = x[i] + in[i];
+}
+
+void chacha_block(seed_t seed, std::uint64_t stream, std::uint64_t counter,
+                  std::uint32_t out[16])
+{
+    // "expand 32-byte k", 256-bit key spread from the 64-bit seed, 64-bit
+    // block counter and 64-bit stream number (nonce)
+    std::uint32_t state[16] = {0x61707865, 0x3320646E, 0x79622D32,
+                               0x6B206574};
+    for (int i = 0; i < 4; ++i) {
+        auto key = mix64(seed + 0x9E3779B97F4A7C15 * std::uint64_t(i + 1));
+        state[4 + 2 * i] = std::uint32_t(key);
+        state[5 + 2 * i] = std::uint32_t(key >> 32);
+    }
+    state[12] = std::uint32_t(counter);
+    state[13] = std::uint32_t(counter >> 32);
+    state[14] = std::uint32_t(stream);
+    state[15] = std::uint32_t(stream >> 32);
+    chacha_core(state, out);
+}
+
+unsigned chacha_rng::operator()(unsigned n)
+{
+    // Lemire's multiply-shift, low products below 2^32 mod n are rejected
+    auto product = std::uint64_t(next()) * n;
+    if (std::uint32_t(product) < n) {
+        auto threshold = (0u - n) % n;
+        while (std::uint32_t(product) < threshold)
+            product = std::uint64_t(next()) * n;
+    }
+    return unsigned(product >> 32);
+}
+
+}  // namespace stego
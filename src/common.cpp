@@ -0,0 +1,19 @@
+// Steganography library - common definitions
+
+#include "stego/common.h"
+
+namespace stego {
+
+// from http://www.cse.yorku.ca/~oz/hash.html
+seed_t hash_djb2(const char* str)
+{
+    seed_t hash = 5381;
+    int c;
+
+    while ((c = *str++))
+        hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
+
+    return hash;
+}
+
+}  // namespace stego
@@ -0,0 +1,141 @@
+// Steganography library - payload compression
+
+#include "stego/compression.h"
+#include "stego/common.h"
+#include <zlib.h>
+
+using namespace std;
+
+namespace stego {
+
+namespace {
+
+// size of output buffer handed to sinks
+constexpr size_t out_bytes = size_t(1) << 16;
+
+// zlib takes sizes as unsigned int, so input is fed in pieces
+constexpr size_t in_bytes = size_t(1) << 30;
+
+}  // namespace
+
+compression parse_compression(const string& text)
+{
+    if (text == "none")
+        return compression::none;
+    if (text == "deflate")
+        return compression::deflate;
+    throw error("Unknown compression " + text);
+}
+
+struct compressor::stream {
+    z_stream z{};
+    char out[out_bytes];
+};
+
+compressor::compressor(compression method, int level) : method_(method)
+{
+    if (method_ == compression::none)
+        return;
+    stream_.reset(new stream);
+    // raw stream (negative window bits): payload header holds the checksum
+    if (deflateInit2(&stream_->z, level, Z_DEFLATED, -15, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK)
+        throw error("Could not initialise compression");
+}
+
+compressor::~compressor()
+{
+    if (stream_)
+        deflateEnd(&stream_->z);
+}
+
+void compressor::write(const char* data, size_t size, const byte_sink& sink)
+{
+    if (method_ == compression::none) {
+        sink(data, size);
+        return;
+    }
+    auto& z = stream_->z;
+    while (size) {
+        auto piece = min(size, in_bytes);
+        z.next_in = (Bytef*)data;
+        z.avail_in = uInt(piece);
+        do {
+            z.next_out = (Bytef*)stream_->out;
+            z.avail_out = uInt(out_bytes);
+            deflate(&z, Z_NO_FLUSH);
+            sink(stream_->out, out_bytes - z.avail_out);
+        } while (z.avail_out == 0);
+        data += piece;
+        size -= piece;
+    }
+}
+
+void compressor::finish(const byte_sink& sink)
+{
+    if (method_ == compression::none)
+        return;
+    auto& z = stream_->z;
+    z.next_in = nullptr;
+    z.avail_in = 0;
+    int status;
+    do {
+        z.next_out = (Bytef*)stream_->out;
+        z.avail_out = uInt(out_bytes);
+        status = deflate(&z, Z_FINISH);
+        sink(stream_->out, out_bytes - z.avail_out);
+    } while (status == Z_OK);
+    if (status != Z_STREAM_END)
+        throw error("Could not compress message file");
+}
+
+struct decompressor::stream {
+    z_stream z{};
+    char out[out_bytes];
+};
+
+decompressor::decompressor(compression method) : method_(method)
+{
+    if (method_ == compression::none)
+        return;
+    stream_.reset(new stream);
+    if (inflateInit2(&stream_->z, -15) != Z_OK)
+        throw error("Could not initialise decompression");
+}
+
+decompressor::~decompressor()
+{
+    if (stream_)
+        inflateEnd(&stream_->z);
+}
+
+void decompressor::write(const char* data, size_t size, const byte_sink& sink)
+{
+    if (method_ == compression::none) {
+        sink(data, size);
+        return;
+    }
+    auto& z = stream_->z;
+    while (size && !finished_) {
+        auto piece = min(size, in_bytes);
+        z.next_in = (Bytef*)data;
+        z.avail_in = uInt(piece);
+        do {
+            z.next_out = (Bytef*)stream_->out;
+            z.avail_out = uInt(out_bytes);
+            auto status = inflate(&z, Z_NO_FLUSH);
+            if (status != Z_OK && status != Z_STREAM_END &&
+                status != Z_BUF_ERROR)
+                throw error("Corrupted compressed message file");
+            sink(stream_->out, out_bytes - z.avail_out);
+            if (status == Z_STREAM_END) {
+                finished_ = true;
+                break;
+            }
+        } while (z.avail_out == 0 || z.avail_in != 0);
+        data += piece;
+        size -= piece;
+    }
+}
+
+}  // namespace stego
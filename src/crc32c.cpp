@@ -0,0 +1,221 @@
+// Steganography library - CRC32C
+
+#include "stego/crc32c.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#if (defined(__x86_64__) || defined(_M_X64)) && defined(__GNUC__)
+#include <nmmintrin.h>
+#define STEGO_CRC32C_SSE42  // compiled with target attribute, runtime checked
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define STEGO_CRC32C_ARM
+#endif
+
+using namespace cv;
+using namespace std;
+
+namespace stego {
+
+namespace {
+
+// reflected Castagnoli polynomial
+constexpr uint32_t polynomial = 0x82F63B78;
+
+// buffers of at least two blocks are checksummed in parallel
+constexpr size_t parallel_block = size_t(1) << 20;
+
+// runs over inverted crc, as do the kernels below
+using kernel = uint32_t (*)(const uchar* data, size_t size, uint32_t crc);
+
+uint32_t crc_scalar(const uchar* data, size_t size, uint32_t crc)
+{
+    static const auto table = [] {
+        vector<uint32_t> entries(256);
+        for (uint32_t i = 0; i < 256; ++i) {
+            auto value = i;
+            for (int bit = 0; bit < 8; ++bit)
+                value = value & 1 ? value >> 1 ^ polynomial : value >> 1;
+            entries[i] = value;
+        }
+        return entries;
+    }();
+    for (size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ crc >> 8;
+    return crc;
+}
+
+#ifdef STEGO_CRC32C_SSE42
+
+__attribute__((target("sse4.2"))) uint32_t crc_sse42(const uchar* data,
+                                                     size_t size,
+                                                     uint32_t crc)
+{
+    uint64_t wide = crc;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        wide = _mm_crc32_u64(wide, word);
+    }
+    crc = uint32_t(wide);
+    for (; i < size; ++i)
+        crc = _mm_crc32_u8(crc, data[i]);
+    return crc;
+}
+
+#endif
+
+#ifdef STEGO_CRC32C_ARM
+
+uint32_t crc_arm(const uchar* data, size_t size, uint32_t crc)
+{
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        crc = __crc32cd(crc, word);
+    }
+    for (; i < size; ++i)
+        crc = __crc32cb(crc, data[i]);
+    return crc;
+}
+
+#endif
+
+// choosing the fastest kernel the CPU supports (once)
+kernel best_kernel()
+{
+    static const kernel chosen = [] {
+#if defined(STEGO_CRC32C_SSE42)
+        if (__builtin_cpu_supports("sse4.2"))
+            return kernel(crc_sse42);
+#elif defined(STEGO_CRC32C_ARM)
+        return kernel(crc_arm);
+#endif
+        return kernel(crc_scalar);
+    }();
+    return chosen;
+}
+
+// GF(2) matrix (32 columns) times vector
+uint32_t matrix_times(const uint32_t* matrix, uint32_t vector)
+{
+    uint32_t sum = 0;
+    for (; vector; vector >>= 1, ++matrix)
+        if (vector & 1)
+            sum ^= *matrix;
+    return sum;
+}
+
+void matrix_square(uint32_t* square, const uint32_t* matrix)
+{
+    for (int n = 0; n < 32; ++n)
+        square[n] = matrix_times(matrix, matrix[n]);
+}
+
+// checksums of blocks of a buffer
+class crc_blocks : public ParallelLoopBody {
+public:
+    crc_blocks(const uchar* data, size_t size, uint32_t* crcs)
+        : data_(data), size_(size), crcs_(crcs)
+    {
+    }
+
+    void operator()(const Range& blocks) const override
+    {
+        for (int block = blocks.start; block < blocks.end; ++block) {
+            auto first = size_t(block) * parallel_block;
+            auto count = min(parallel_block, size_ - first);
+            crcs_[block] = crc32c(data_ + first, count);
+        }
+    }
+
+private:
+    const uchar* data_;
+    size_t size_;
+    uint32_t* crcs_;
+};
+
+}  // namespace
+
+uint32_t crc32c(const void* data, size_t size, uint32_t crc)
+{
+    auto bytes = (const uchar*)data;
+    if (size < 2 * parallel_block)
+        return ~best_kernel()(bytes, size, ~crc);
+
+    auto blocks = (size + parallel_block - 1) / parallel_block;
+    vector<uint32_t> crcs(blocks);
+    parallel_for_(Range(0, int(blocks)), crc_blocks(bytes, size, crcs.data()));
+    const crc32c_combiner full_block(parallel_block);
+    for (size_t block = 0; block + 1 < blocks; ++block)
+        crc = full_block(crc, crcs[block]);
+    return crc32c_combine(crc, crcs[blocks - 1],
+                          size - (blocks - 1) * parallel_block);
+}
+
+uint32_t crc32c_combine(uint32_t crc1, uint32_t crc2, uint64_t size2)
+{
+    return crc32c_combiner(size2)(crc1, crc2);
+}
+
+crc32c_combiner::crc32c_combiner(uint64_t size2)
+{
+    // GF(2) matrix appending size2 zero bytes, identity for none
+    uint32_t shift[32];
+    for (int n = 0; n < 32; ++n)
+        shift[n] = uint32_t(1) << n;
+
+    // odd starts as the operator appending one zero bit to crc1; repeated
+    // squaring gives operators appending 2, 4, 8... zero bits, those of one
+    // byte and up applied for every bit set in size2
+    uint32_t even[32];
+    uint32_t odd[32];
+    odd[0] = polynomial;
+    for (int n = 1; n < 32; ++n)
+        odd[n] = uint32_t(1) << (n - 1);
+    matrix_square(even, odd);  // 2 zero bits
+    matrix_square(odd, even);  // 4 zero bits
+    // operators are accumulated into shift (operators of zero runs
+    // commute, so the order of products does not matter)
+    auto apply = [&](const uint32_t* matrix) {
+        uint32_t product[32];
+        for (int n = 0; n < 32; ++n)
+            product[n] = matrix_times(matrix, shift[n]);
+        copy(begin(product), end(product), begin(shift));
+    };
+    while (size2 != 0) {
+        matrix_square(even, odd);  // first pass: 8 zero bits (one byte)
+        if (size2 & 1)
+            apply(even);
+        size2 >>= 1;
+        if (size2 == 0)
+            break;
+        matrix_square(odd, even);
+        if (size2 & 1)
+            apply(odd);
+        size2 >>= 1;
+    }
+
+    // the matrix is linear, so each entry adds one column to the entry
+    // without its lowest bit
+    for (int k = 0; k < 4; ++k) {
+        table_[k][0] = 0;
+        for (int b = 1; b < 256; ++b) {
+            int low = 0;
+            while (!(b >> low & 1))
+                ++low;
+            table_[k][b] = table_[k][b & (b - 1)] ^ shift[8 * k + low];
+        }
+    }
+}
+
+uint32_t crc32c_combiner::operator()(uint32_t crc1, uint32_t crc2) const
+{
+    return table_[0][crc1 & 0xFF] ^ table_[1][crc1 >> 8 & 0xFF] ^
+           table_[2][crc1 >> 16 & 0xFF] ^ table_[3][crc1 >> 24] ^ crc2;
+}
+
+}  // namespace stego
@@ -0,0 +1,345 @@
+// Steganography library - image files
+
+#include "stego/image_io.h"
+#include "stego/common.h"
+#include "stego/report.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <memory>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace cv;
+using namespace std;
+
+namespace stego {
+
+namespace {
+
+const char magic[8] = {'S', 'T', 'E', 'G', 'O', 'R', 'A', 'W'};
+const char* const raw_extension = ".sraw";
+
+struct raw_header {
+    char magic[8];
+    uint32_t header_size;
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t channels;
+    uint32_t reserved[2];
+};
+static_assert(sizeof(raw_header) == 32, "raw header must take 32 bytes");
+
+bool valid(const raw_header& header, size_t file_size)
+{
+    return memcmp(header.magic, magic, sizeof(magic)) == 0 &&
+           header.header_size == sizeof(raw_header) &&
+           (header.channels == 1 || header.channels == 3) &&
+           header.rows <= INT32_MAX && header.cols <= INT32_MAX &&
+           file_size - sizeof(raw_header) >=
+               uint64_t(header.rows) * header.cols * header.channels;
+}
+
+// converting raw image to number of channels requested by imread flags
+// (with the fixed point weights cv::imread uses)
+Mat converted(const Mat& image, int channels)
+{
+    Mat result(image.rows, image.cols, channels == 1 ? CV_8UC1 : CV_8UC3);
+    for (int row = 0; row < image.rows; ++row) {
+        auto src = image.ptr<uchar>(row);
+        auto dst = result.ptr<uchar>(row);
+        for (int col = 0; col < image.cols; ++col)
+            if (channels == 1) {
+                auto bgr = src + 3 * col;
+                dst[col] = uchar(
+                    (bgr[0] * 1868 + bgr[1] * 9617 + bgr[2] * 4899 + 8192) >>
+                    14);
+            } else {
+                dst[3 * col] = dst[3 * col + 1] = dst[3 * col + 2] = src[col];
+            }
+    }
+    return result;
+}
+
+raw_header make_header(int rows, int cols, int type)
+{
+    raw_header header = {};
+    memcpy(header.magic, magic, sizeof(magic));
+    header.header_size = sizeof(header);
+    header.rows = uint32_t(rows);
+    header.cols = uint32_t(cols);
+    header.channels = type == CV_8UC1 ? 1 : 3;
+    return header;
+}
+
+}  // namespace
+
+#ifdef _WIN32
+
+// no mapping on Windows, raw images are read and written with streams
+image_file::image_file(const string& path, int flags)
+{
+    auto file = ifstream(path, ios::binary | ios::ate);
+    if (!file.is_open())
+        return;
+    auto file_size = size_t(file.tellg());
+    file.seekg(0, ios::beg);
+    add(counter::bytes_read, file_size);
+    raw_header header;
+    if (file_size < sizeof(header) ||
+        !file.read((char*)&header, sizeof(header)) ||
+        !valid(header, file_size)) {
+        image_ = imread(path, flags);
+        return;
+    }
+    Mat raw(int(header.rows), int(header.cols),
+            header.channels == 1 ? CV_8UC1 : CV_8UC3);
+    if (!file.read((char*)raw.data, raw.total() * raw.elemSize()))
+        return;
+    auto channels = flags == IMREAD_GRAYSCALE ? 1 : 3;
+    image_ = raw.channels() == channels ? raw : converted(raw, channels);
+}
+
+image_file image_file::create(const string& path, int rows, int cols,
+                              int type)
+{
+    if (type != CV_8UC1 && type != CV_8UC3)
+        throw error("Raw images must be of 8-bit 1 or 3 channels");
+    image_file created;
+    created.image_ = Mat(rows, cols, type);
+    // written when image_file is destroyed
+    created.mapping_ = new string(path);
+    return created;
+}
+
+void image_file::unmap()
+{
+    if (mapping_) {
+        unique_ptr<string> path((string*)mapping_);
+        auto header = make_header(image_.rows, image_.cols, image_.type());
+        auto file = ofstream(*path, ios::binary | ios::trunc);
+        file.write((const char*)&header, sizeof(header));
+        for (int row = 0; row < image_.rows; ++row)
+            file.write(image_.ptr<char>(row), image_.cols * image_.elemSize());
+    }
+    mapping_ = nullptr;
+}
+
+#else
+
+image_file::image_file(const string& path, int flags)
+{
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat status;
+    raw_header header;
+    if (fstat(fd, &status) == 0)
+        add(counter::bytes_read, uint64_t(status.st_size));
+    else
+        status.st_size = 0;
+    if (size_t(status.st_size) < sizeof(header) ||
+        ::read(fd, &header, sizeof(header)) != ssize_t(sizeof(header)) ||
+        !valid(header, size_t(status.st_size))) {
+        ::close(fd);
+        image_ = imread(path, flags);  // not a raw image
+        return;
+    }
+
+    // private mapping: changes made to the image do not reach the file
+    auto bytes = size_t(status.st_size);
+    auto mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                        fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return;
+    mapping_ = mapping;
+    mapping_bytes_ = bytes;
+
+    Mat raw(int(header.rows), int(header.cols),
+            header.channels == 1 ? CV_8UC1 : CV_8UC3,
+            (uchar*)mapping + sizeof(header));
+    auto channels = flags == IMREAD_GRAYSCALE ? 1 : 3;
+    if (raw.channels() == channels) {
+        image_ = raw;
+    } else {
+        image_ = converted(raw, channels);
+        unmap();
+    }
+}
+
+image_file image_file::create(const string& path, int rows, int cols,
+                              int type)
+{
+    if (type != CV_8UC1 && type != CV_8UC3)
+        throw error("Raw images must be of 8-bit 1 or 3 channels");
+    auto header = make_header(rows, cols, type);
+    auto bytes =
+        sizeof(header) + size_t(rows) * size_t(cols) * header.channels;
+
+    auto fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw error("Could not create " + path);
+    if (ftruncate(fd, off_t(bytes)) != 0) {
+        ::close(fd);
+        throw error("Could not create " + path);
+    }
+    auto mapping =
+        mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        throw error("Could not create " + path);
+    memcpy(mapping, &header, sizeof(header));
+
+    image_file created;
+    created.mapping_ = mapping;
+    created.mapping_bytes_ = bytes;
+    created.image_ = Mat(rows, cols, type, (uchar*)mapping + sizeof(header));
+    return created;
+}
+
+void image_file::unmap()
+{
+    if (mapping_)
+        munmap(mapping_, mapping_bytes_);
+    mapping_ = nullptr;
+    mapping_bytes_ = 0;
+}
+
+#endif
+
+image_file::image_file(image_file&& other) noexcept
+    : image_(other.image_),
+      mapping_(other.mapping_),
+      mapping_bytes_(other.mapping_bytes_)
+{
+    other.image_ = Mat();
+    other.mapping_ = nullptr;
+    other.mapping_bytes_ = 0;
+}
+
+image_file& image_file::operator=(image_file&& other) noexcept
+{
+    if (this != &other) {
+        unmap();
+        image_ = other.image_;
+        mapping_ = other.mapping_;
+        mapping_bytes_ = other.mapping_bytes_;
+        other.image_ = Mat();
+        other.mapping_ = nullptr;
+        other.mapping_bytes_ = 0;
+    }
+    return *this;
+}
+
+image_file::~image_file()
+{
+    unmap();
+}
+
+raw_reader::raw_reader(const string& path)
+    : file_(path, ios::binary | ios::ate), path_(path)
+{
+    if (!file_.is_open())
+        throw error("Could not open or find " + path);
+    auto file_size = size_t(file_.tellg());
+    file_.seekg(0, ios::beg);
+    raw_header header;
+    if (file_size < sizeof(header) ||
+        !file_.read((char*)&header, sizeof(header)) ||
+        !valid(header, file_size))
+        throw error(path + " is not a raw image");
+    rows_ = int(header.rows);
+    cols_ = int(header.cols);
+    type_ = header.channels == 1 ? CV_8UC1 : CV_8UC3;
+}
+
+void raw_reader::read(int first, int count, Mat& image)
+{
+    if (first < 0 || count < 0 || first + count > rows_)
+        throw error("Rows out of " + path_);
+    image.create(count, cols_, type_);
+    auto row_bytes = size_t(cols_) * image.elemSize();
+    file_.seekg(streamoff(sizeof(raw_header) + size_t(first) * row_bytes));
+    for (int row = 0; row < count; ++row)
+        if (!file_.read(image.ptr<char>(row), row_bytes))
+            throw error("Could not read " + path_);
+    add(counter::bytes_read, count * row_bytes);
+}
+
+raw_writer::raw_writer(const string& path, int rows, int cols, int type)
+    : file_(path, ios::binary | ios::trunc),
+      path_(path),
+      rows_(rows),
+      cols_(cols),
+      type_(type)
+{
+    if (type != CV_8UC1 && type != CV_8UC3)
+        throw error("Raw images must be of 8-bit 1 or 3 channels");
+    auto header = make_header(rows, cols, type);
+    if (!file_.is_open() || !file_.write((const char*)&header, sizeof(header)))
+        throw error("Could not create " + path);
+    add(counter::bytes_written, sizeof(header));
+}
+
+void raw_writer::write(int first, const Mat& image)
+{
+    if (image.cols != cols_ || image.type() != type_ || first < 0 ||
+        first + image.rows > rows_)
+        throw error("Rows do not fit " + path_);
+    auto row_bytes = size_t(cols_) * image.elemSize();
+    file_.seekp(streamoff(sizeof(raw_header) + size_t(first) * row_bytes));
+    for (int row = 0; row < image.rows; ++row)
+        if (!file_.write(image.ptr<char>(row), row_bytes))
+            throw error("Could not save " + path_);
+    written_ += image.rows;
+    add(counter::bytes_written, image.rows * row_bytes);
+}
+
+void raw_writer::close()
+{
+    if (written_ != rows_)
+        throw error("Rows missing in " + path_);
+    file_.close();
+    if (!file_)
+        throw error("Could not save " + path_);
+}
+
+bool is_raw_path(const string& path)
+{
+    auto length = strlen(raw_extension);
+    return path.size() >= length &&
+           path.compare(path.size() - length, length, raw_extension) == 0;
+}
+
+bool write_image(const string& path, const Mat& image, int png_level)
+{
+    if (!is_raw_path(path)) {
+        vector<int> compression_params = {IMWRITE_PNG_COMPRESSION,
+                                          png_level};
+        if (!imwrite(path, image, compression_params))
+            return false;
+        struct stat status;
+        if (stat(path.c_str(), &status) == 0)
+            add(counter::bytes_written, uint64_t(status.st_size));
+        return true;
+    }
+    try {
+        auto file = image_file::create(path, image.rows, image.cols,
+                                       image.type());
+        image.copyTo(file.image());
+        add(counter::bytes_written,
+            sizeof(raw_header) + image.total() * image.elemSize());
+        return true;
+    } catch (const error&) {
+        return false;
+    }
+}
+
+}  // namespace stego
@@ -0,0 +1,295 @@
+// Steganography library - key derivation
+
+#include "stego/key.h"
+#include "stego/chacha.h"
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <random>
+#include <vector>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace stego {
+
+namespace {
+
+// fixed library key of the keyed hash ("stego ke", "yed seed")
+constexpr uint64_t seed_key0 = 0x737465676F206B65;
+constexpr uint64_t seed_key1 = 0x7965642073656564;
+
+// fixed Balloon hashing salt ("stego ba", "lloon sa")
+constexpr uint64_t balloon_salt0 = 0x7374656761206261;
+constexpr uint64_t balloon_salt1 = 0x6C6C6F6F6E207361;
+
+// Balloon hashing mixes every block with this many pseudorandom others
+constexpr int balloon_delta = 3;
+
+inline uint64_t rotl(uint64_t x, int n) { return (x << n) | (x >> (64 - n)); }
+
+inline void sip_round(uint64_t& v0, uint64_t& v1, uint64_t& v2, uint64_t& v3)
+{
+    v0 += v1;
+    v1 = rotl(v1, 13);
+    v1 ^= v0;
+    v0 = rotl(v0, 32);
+    v2 += v3;
+    v3 = rotl(v3, 16);
+    v3 ^= v2;
+    v0 += v3;
+    v3 = rotl(v3, 21);
+    v3 ^= v0;
+    v2 += v1;
+    v1 = rotl(v1, 17);
+    v1 ^= v2;
+    v2 = rotl(v2, 32);
+}
+
+// 32-byte block of Balloon hashing buffer
+struct block {
+    uint32_t words[8];
+};
+
+// compression function of Balloon hashing: ChaCha8 core of both blocks
+// (counter mixed into the first one) folded to one block
+block compress(uint64_t& counter, const block& a, const block& b)
+{
+    uint32_t in[16], out[16];
+    for (int i = 0; i < 8; ++i) {
+        in[i] = a.words[i];
+        in[8 + i] = b.words[i];
+    }
+    in[0] ^= uint32_t(counter);
+    in[1] ^= uint32_t(counter >> 32);
+    ++counter;
+    chacha_core(in, out);
+    block result;
+    for (int i = 0; i < 8; ++i)
+        result.words[i] = out[i] ^ out[8 + i];
+    return result;
+}
+
+block from_words(uint64_t w0, uint64_t w1, uint64_t w2, uint64_t w3)
+{
+    block result;
+    uint64_t words[] = {w0, w1, w2, w3};
+    for (int i = 0; i < 4; ++i) {
+        result.words[2 * i] = uint32_t(words[i]);
+        result.words[2 * i + 1] = uint32_t(words[i] >> 32);
+    }
+    return result;
+}
+
+seed_t balloon(const string& password, uint32_t memory_kib, uint32_t passes)
+{
+    const size_t blocks = size_t(memory_kib) * 1024 / sizeof(block);
+    const auto salt = from_words(balloon_salt0, balloon_salt1,
+                                 memory_kib, passes);
+    // password of any length absorbed into one block
+    block secret;
+    for (int i = 0; i < 4; ++i) {
+        auto word = siphash24(password.data(), password.size(),
+                              balloon_salt0, balloon_salt1 + i);
+        secret.words[2 * i] = uint32_t(word);
+        secret.words[2 * i + 1] = uint32_t(word >> 32);
+    }
+
+    // expanding
+    uint64_t counter = 0;
+    vector<block> buffer;
+    try {
+        buffer.resize(blocks);
+    } catch (const bad_alloc&) {
+        throw error("Not enough memory for Balloon hashing (" +
+                    to_string(memory_kib) + " KiB)");
+    }
+    buffer[0] = compress(counter, secret, salt);
+    const block zero{};
+    for (size_t m = 1; m < blocks; ++m)
+        buffer[m] = compress(counter, buffer[m - 1], zero);
+
+    // mixing, every block with the previous one and with blocks chosen by
+    // position (data-independent, so timing does not depend on password)
+    for (uint32_t t = 0; t < passes; ++t)
+        for (size_t m = 0; m < blocks; ++m) {
+            buffer[m] = compress(counter, buffer[(m + blocks - 1) % blocks],
+                                 buffer[m]);
+            for (int i = 0; i < balloon_delta; ++i) {
+                auto index = compress(counter, salt, from_words(t, m, i, 0));
+                auto other = (uint64_t(index.words[1]) << 32 |
+                              index.words[0]) % blocks;
+                buffer[m] = compress(counter, buffer[m], buffer[other]);
+            }
+        }
+
+    const auto& last = buffer[blocks - 1];
+    return uint64_t(last.words[1]) << 32 | last.words[0];
+}
+
+// first line of file descriptor, read byte by byte so nothing past the line
+// is consumed
+string read_line(int fd, const string& source)
+{
+    string line;
+    char c;
+    for (;;) {
+#ifdef _WIN32
+        auto count = _read(fd, &c, 1);
+#else
+        auto count = ::read(fd, &c, 1);
+#endif
+        if (count < 0)
+            throw error("Could not read password from " + source);
+        if (count == 0 || c == '\n')
+            break;
+        line += c;
+    }
+    return line;
+}
+
+}  // namespace
+
+string read_password(const string& source)
+{
+    auto colon = source.find(':');
+    auto kind = source.substr(0, colon);
+    auto name = colon == string::npos ? string() : source.substr(colon + 1);
+    string password;
+    if (kind == "env" && !name.empty()) {
+        auto value = getenv(name.c_str());
+        if (!value)
+            throw error("Password variable " + name + " is not set");
+        password = value;
+    } else if (kind == "fd" && !name.empty()) {
+        size_t used = 0;
+        int fd = -1;
+        try {
+            fd = stoi(name, &used);
+        } catch (const logic_error&) {
+        }
+        if (used != name.size() || fd < 0)
+            throw error("Unknown password source " + source);
+        password = read_line(fd, source);
+    } else if (kind == "file" && !name.empty()) {
+        auto file = ifstream(name);
+        if (!file.is_open())
+            throw error("Could not open or find " + name);
+        getline(file, password);
+    } else {
+        throw error("Unknown password source " + source);
+    }
+    if (!password.empty() && password.back() == '\r')
+        password.pop_back();
+    return password;
+}
+
+key_params key_params::parse(const string& text)
+{
+    if (text == "djb2")
+        return {key_derivation::djb2};
+    if (text == "keyed")
+        return {key_derivation::keyed};
+    key_params params{key_derivation::balloon};
+    if (text == "balloon")
+        return params;
+    // balloon:<memory KiB>:<passes>
+    const string prefix = "balloon:";
+    auto colon = text.find(':', prefix.size());
+    if (text.compare(0, prefix.size(), prefix) == 0 && colon != string::npos) {
+        try {
+            size_t memory_used, passes_used;
+            auto memory = stoull(text.substr(prefix.size()), &memory_used);
+            auto passes = stoull(text.substr(colon + 1), &passes_used);
+            if (memory > max_balloon_kib)
+                throw error("Balloon hashing memory over " +
+                            to_string(max_balloon_kib) + " KiB");
+            if (memory_used == colon - prefix.size() &&
+                passes_used == text.size() - colon - 1 && memory > 0 &&
+                passes > 0 && passes <= UINT32_MAX) {
+                params.memory_kib = uint32_t(memory);
+                params.passes = uint32_t(passes);
+                return params;
+            }
+        } catch (const logic_error&) {
+        }
+    }
+    throw error("Unknown key derivation " + text);
+}
+
+uint64_t siphash24(const void* data, size_t size, uint64_t k0, uint64_t k1)
+{
+    auto bytes = static_cast<const unsigned char*>(data);
+    uint64_t v0 = k0 ^ 0x736F6D6570736575;
+    uint64_t v1 = k1 ^ 0x646F72616E646F6D;
+    uint64_t v2 = k0 ^ 0x6C7967656E657261;
+    uint64_t v3 = k1 ^ 0x7465646279746573;
+
+    // little-endian 8-byte words, the last one padded and holding size
+    auto word_at = [&](size_t first, size_t count) {
+        uint64_t word = 0;
+        for (size_t i = 0; i < count; ++i)
+            word |= uint64_t(bytes[first + i]) << (8 * i);
+        return word;
+    };
+    size_t first = 0;
+    for (; first + 8 <= size; first += 8) {
+        auto m = word_at(first, 8);
+        v3 ^= m;
+        sip_round(v0, v1, v2, v3);
+        sip_round(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+    auto m = word_at(first, size - first) | uint64_t(size) << 56;
+    v3 ^= m;
+    sip_round(v0, v1, v2, v3);
+    sip_round(v0, v1, v2, v3);
+    v0 ^= m;
+
+    v2 ^= 0xFF;
+    for (int i = 0; i < 4; ++i)
+        sip_round(v0, v1, v2, v3);
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+seed_t derive_seed(const string& password, const key_params& params)
+{
+    switch (params.method) {
+    case key_derivation::djb2:
+        return hash_djb2(password.c_str());
+    case key_derivation::keyed:
+        return siphash24(password.data(), password.size(), seed_key0,
+                         seed_key1);
+    case key_derivation::balloon:
+        if (params.memory_kib == 0 || params.passes == 0)
+            throw error("Balloon hashing needs memory and passes");
+        if (params.memory_kib > max_balloon_kib)
+            throw error("Balloon hashing memory over " +
+                        to_string(max_balloon_kib) + " KiB");
+        return balloon(password, params.memory_kib, params.passes);
+    }
+    throw error("Unknown key derivation");
+}
+
+key_cache::key_cache(size_t entries)
+    : seeds_(entries),
+      hash_key_(uint64_t(random_device()()) << 32 | random_device()())
+{
+}
+
+seed_t key_cache::derive(const string& password, const key_params& params)
+{
+    key k(siphash24(password.data(), password.size(), hash_key_, seed_key1),
+          int(params.method), params.memory_kib, params.passes);
+    if (auto seed = seeds_.find(k))
+        return *seed;
+    auto seed = derive_seed(password, params);
+    seeds_.insert(k, make_shared<const seed_t>(seed));
+    return seed;
+}
+
+}  // namespace stego
@@ -0,0 +1,187 @@
+// Steganography library - noise generation
+
+#include "stego/noise.h"
+#include "stego/chacha.h"
+#include <cmath>
+
+namespace stego {
+
+namespace {
+
+// number of Philox blocks generated at once; lanes of a batch do not depend
+// on each other so the integer rounds are vectorized by the compiler
+constexpr int batch = 8;
+
+// Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2,
+// 3") applied to counters first, first + 1, ..., first + batch - 1
+void philox4x32(std::uint64_t first, seed_t seed,
+                std::uint32_t out[4][batch])
+{
+    const std::uint32_t m0 = 0xD2511F53, m1 = 0xCD9E8D57;
+    const std::uint32_t w0 = 0x9E3779B9, w1 = 0xBB67AE85;
+
+    std::uint32_t c0[batch], c1[batch], c2[batch], c3[batch];
+    for (int i = 0; i < batch; ++i) {
+        c0[i] = std::uint32_t(first + i);
+        c1[i] = std::uint32_t((first + i) >> 32);
+        c2[i] = 0;
+        c3[i] = 0;
+    }
+    auto k0 = std::uint32_t(seed);
+    auto k1 = std::uint32_t(seed >> 32);
+    for (int round = 0; round < 10; ++round) {
+        for (int i = 0; i < batch; ++i) {
+            auto p0 = std::uint64_t(m0) * c0[i];
+            auto p1 = std::uint64_t(m1) * c2[i];
+            auto n0 = std::uint32_t(p1 >> 32) ^ c1[i] ^ k0;
+            auto n2 = std::uint32_t(p0 >> 32) ^ c3[i] ^ k1;
+            c1[i] = std::uint32_t(p1);
+            c3[i] = std::uint32_t(p0);
+            c0[i] = n0;
+            c2[i] = n2;
+        }
+        k0 += w0;
+        k1 += w1;
+    }
+    for (int i = 0; i < batch; ++i) {
+        out[0][i] = c0[i];
+        out[1][i] = c1[i];
+        out[2][i] = c2[i];
+        out[3][i] = c3[i];
+    }
+}
+
+// four standard normal values per Philox block (Box-Muller transform)
+void gaussians(std::uint64_t first, seed_t seed, double out[batch * 4])
+{
+    const double to_unit = 1.0 / 4294967296.0;
+    const double two_pi = 6.283185307179586;
+
+    std::uint32_t bits[4][batch];
+    philox4x32(first, seed, bits);
+    for (int i = 0; i < batch; ++i)
+        for (int pair = 0; pair < 2; ++pair) {
+            auto u1 = (bits[2 * pair][i] + 1.0) * to_unit;  // (0, 1]
+            auto u2 = bits[2 * pair + 1][i] * to_unit;      // [0, 1)
+            auto radius = std::sqrt(-2 * std::log(u1));
+            out[i * 4 + 2 * pair] = radius * std::cos(two_pi * u2);
+            out[i * 4 + 2 * pair + 1] = radius * std::sin(two_pi * u2);
+        }
+}
+
+// sixteen standard normal values per ChaCha block, one batch of Philox
+// blocks worth of ChaCha blocks at a time
+void chacha_gaussians(std::uint64_t first, seed_t seed,
+                      double out[batch * 4])
+{
+    const double to_unit = 1.0 / 4294967296.0;
+    const double two_pi = 6.283185307179586;
+
+    for (int block = 0; block < batch / 4; ++block) {
+        std::uint32_t bits[16];
+        chacha_block(seed, noise_stream, first + block, bits);
+        for (int pair = 0; pair < 8; ++pair) {
+            auto u1 = (bits[2 * pair] + 1.0) * to_unit;  // (0, 1]
+            auto u2 = bits[2 * pair + 1] * to_unit;      // [0, 1)
+            auto radius = std::sqrt(-2 * std::log(u1));
+            out[block * 16 + 2 * pair] = radius * std::cos(two_pi * u2);
+            out[block * 16 + 2 * pair + 1] = radius * std::sin(two_pi * u2);
+        }
+    }
+}
+
+inline uchar noised(uchar value, double gaussian, double sigma)
+{
+    int noised_value = gaussian * sigma + value;
+    if (noised_value > 255)  // preventing overflow
+        return 255;
+    else if (noised_value < 0)
+        return 0;
+    return uchar(noised_value);
+}
+
+class noise_rows : public cv::ParallelLoopBody {
+public:
+    noise_rows(const cv::Mat_<cv::Vec3b>& src, cv::Mat_<cv::Vec3b>& dst,
+               double sigma, seed_t seed, noise_generator generator,
+               std::uint64_t first)
+        : src_(src),
+          dst_(dst),
+          sigma_(sigma),
+          seed_(seed),
+          generator_(generator),
+          first_(first)
+    {
+    }
+
+    void operator()(const cv::Range& rows) const override
+    {
+        auto row_bytes = std::size_t(src_.cols) * 3;
+        for (int row = rows.start; row < rows.end; ++row)
+            add_gaussian_noise(src_.ptr<uchar>(row), dst_.ptr<uchar>(row),
+                               row_bytes, first_ + row * row_bytes, sigma_,
+                               seed_, generator_);
+    }
+
+private:
+    const cv::Mat_<cv::Vec3b>& src_;
+    cv::Mat_<cv::Vec3b>& dst_;
+    double sigma_;
+    seed_t seed_;
+    noise_generator generator_;
+    std::uint64_t first_;
+};
+
+}  // namespace
+
+void add_gaussian_noise(const cv::Mat_<cv::Vec3b>& src,
+                        cv::Mat_<cv::Vec3b>& dst, double sigma, cv::RNG& rng)
+{
+    if (dst.data != src.data)
+        src.copyTo(dst);  // into dst memory when of src size
+    int noised_value;
+    for (auto& pixel : dst)         // for each pixel
+        for (auto i : {0, 1, 2}) {  // for each channel
+            noised_value = rng.gaussian(sigma) + pixel[i];
+            if (noised_value > 255)  // preventing overflow
+                pixel[i] = 255;
+            else if (noised_value < 0)
+                pixel[i] = 0;
+            else
+                pixel[i] = noised_value;
+        }
+}
+
+void add_gaussian_noise(const cv::Mat_<cv::Vec3b>& src,
+                        cv::Mat_<cv::Vec3b>& dst, double sigma, seed_t seed,
+                        noise_generator generator, std::uint64_t first)
+{
+    if (dst.data != src.data)
+        dst.create(src.size());
+    cv::parallel_for_(cv::Range(0, src.rows),
+                      noise_rows(src, dst, sigma, seed, generator, first));
+}
+
+void add_gaussian_noise(const uchar* src, uchar* dst, std::size_t count,
+                        std::uint64_t first, double sigma, seed_t seed,
+                        noise_generator generator)
+{
+    // byte with linear offset n takes value n % 4 of Philox block n / 4 (or
+    // value n % 16 of ChaCha block n / 16)
+    const std::uint64_t block_bytes = batch * 4;
+    auto last = first + count;
+    double values[block_bytes];
+    for (auto start = first / block_bytes * block_bytes; start < last;
+         start += block_bytes) {
+        if (generator == noise_generator::chacha)
+            chacha_gaussians(start / 16, seed, values);
+        else
+            gaussians(start / 4, seed, values);
+        auto from = std::max(start, first);
+        auto to = std::min(start + block_bytes, last);
+        for (auto n = from; n < to; ++n)
+            dst[n - first] = noised(src[n - first], values[n - start], sigma);
+    }
+}
+
+}  // namespace stego
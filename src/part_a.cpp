@@ -0,0 +1,252 @@
+// Steganography library - Part A (Simple Steganography)
+
+#include "stego/part_a.h"
+#include "stego/common.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define STEGO_PART_A_SSE2
+#if defined(__GNUC__)
+#define STEGO_PART_A_AVX2  // compiled with target attribute, runtime checked
+#endif
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define STEGO_PART_A_NEON
+#endif
+
+using namespace cv;
+using namespace std;
+
+namespace stego {
+namespace part_a {
+
+namespace {
+
+// Both directions are fused into one pass reading each input once:
+// encoding adds 1 (saturating) to carrier pixels under black (0) message
+// pixels and decoding gives 255 where encoded pixel is not greater than
+// carrier pixel and 0 elsewhere, as
+//   ones - threshold(message) + carrier and
+//   (ones - (encoded - carrier)) * 255
+// with saturating arithmetic do.
+using kernel = void (*)(const uchar* carrier, const uchar* other, uchar* out,
+                        size_t count);
+
+void encode_scalar(const uchar* carrier, const uchar* message, uchar* encoded,
+                   size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        encoded[i] = uchar(carrier[i] + (message[i] == 0 && carrier[i] < 255));
+}
+
+void decode_scalar(const uchar* carrier, const uchar* encoded, uchar* decoded,
+                   size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        decoded[i] = encoded[i] <= carrier[i] ? 255 : 0;
+}
+
+#ifdef STEGO_PART_A_SSE2
+
+void encode_sse2(const uchar* carrier, const uchar* message, uchar* encoded,
+                 size_t count)
+{
+    const auto zero = _mm_setzero_si128();
+    const auto one = _mm_set1_epi8(1);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        auto c = _mm_loadu_si128((const __m128i*)(carrier + i));
+        auto m = _mm_loadu_si128((const __m128i*)(message + i));
+        auto bits = _mm_and_si128(_mm_cmpeq_epi8(m, zero), one);
+        _mm_storeu_si128((__m128i*)(encoded + i), _mm_adds_epu8(c, bits));
+    }
+    encode_scalar(carrier + i, message + i, encoded + i, count - i);
+}
+
+void decode_sse2(const uchar* carrier, const uchar* encoded, uchar* decoded,
+                 size_t count)
+{
+    const auto zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        auto c = _mm_loadu_si128((const __m128i*)(carrier + i));
+        auto e = _mm_loadu_si128((const __m128i*)(encoded + i));
+        _mm_storeu_si128((__m128i*)(decoded + i),
+                         _mm_cmpeq_epi8(_mm_subs_epu8(e, c), zero));
+    }
+    decode_scalar(carrier + i, encoded + i, decoded + i, count - i);
+}
+
+#endif
+
+#ifdef STEGO_PART_A_AVX2
+
+__attribute__((target("avx2"))) void encode_avx2(const uchar* carrier,
+                                                 const uchar* message,
+                                                 uchar* encoded, size_t count)
+{
+    const auto zero = _mm256_setzero_si256();
+    const auto one = _mm256_set1_epi8(1);
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        auto c = _mm256_loadu_si256((const __m256i*)(carrier + i));
+        auto m = _mm256_loadu_si256((const __m256i*)(message + i));
+        auto bits = _mm256_and_si256(_mm256_cmpeq_epi8(m, zero), one);
+        _mm256_storeu_si256((__m256i*)(encoded + i),
+                            _mm256_adds_epu8(c, bits));
+    }
+    encode_sse2(carrier + i, message + i, encoded + i, count - i);
+}
+
+__attribute__((target("avx2"))) void decode_avx2(const uchar* carrier,
+                                                 const uchar* encoded,
+                                                 uchar* decoded, size_t count)
+{
+    const auto zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        auto c = _mm256_loadu_si256((const __m256i*)(carrier + i));
+        auto e = _mm256_loadu_si256((const __m256i*)(encoded + i));
+        _mm256_storeu_si256((__m256i*)(decoded + i),
+                            _mm256_cmpeq_epi8(_mm256_subs_epu8(e, c), zero));
+    }
+    decode_sse2(carrier + i, encoded + i, decoded + i, count - i);
+}
+
+#endif
+
+#ifdef STEGO_PART_A_NEON
+
+void encode_neon(const uchar* carrier, const uchar* message, uchar* encoded,
+                 size_t count)
+{
+    const auto one = vdupq_n_u8(1);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        auto c = vld1q_u8(carrier + i);
+        auto m = vld1q_u8(message + i);
+        auto bits = vandq_u8(vceqq_u8(m, vdupq_n_u8(0)), one);
+        vst1q_u8(encoded + i, vqaddq_u8(c, bits));
+    }
+    encode_scalar(carrier + i, message + i, encoded + i, count - i);
+}
+
+void decode_neon(const uchar* carrier, const uchar* encoded, uchar* decoded,
+                 size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+        vst1q_u8(decoded + i,
+                 vcleq_u8(vld1q_u8(encoded + i), vld1q_u8(carrier + i)));
+    decode_scalar(carrier + i, encoded + i, decoded + i, count - i);
+}
+
+#endif
+
+struct kernels {
+    kernel encode;
+    kernel decode;
+};
+
+// choosing the widest kernels the CPU supports (once)
+const kernels& best_kernels()
+{
+    static const kernels chosen = [] {
+#if defined(STEGO_PART_A_AVX2)
+        if (__builtin_cpu_supports("avx2"))
+            return kernels{encode_avx2, decode_avx2};
+#endif
+#if defined(STEGO_PART_A_SSE2)
+        return kernels{encode_sse2, decode_sse2};
+#elif defined(STEGO_PART_A_NEON)
+        return kernels{encode_neon, decode_neon};
+#else
+        return kernels{encode_scalar, decode_scalar};
+#endif
+    }();
+    return chosen;
+}
+
+// applies kernel row by row (or at once to continuous images)
+Mat_<uchar> apply(kernel run, const Mat_<uchar>& carrier,
+                  const Mat_<uchar>& other)
+{
+    Mat_<uchar> result(carrier.size());
+    if (carrier.isContinuous() && other.isContinuous()) {
+        run(carrier.ptr<uchar>(), other.ptr<uchar>(), result.ptr<uchar>(),
+            carrier.total());
+        return result;
+    }
+    for (int row = 0; row < carrier.rows; ++row)
+        run(carrier.ptr<uchar>(row), other.ptr<uchar>(row),
+            result.ptr<uchar>(row), size_t(carrier.cols));
+    return result;
+}
+
+}  // namespace
+
+Mat_<uchar> encode(const Mat_<uchar>& carrier, const Mat_<uchar>& message)
+{
+    if (carrier.size() != message.size())
+        throw error("Images have different dimension");
+
+    // adding 1 on every position where message equals 0; overflow doesn't
+    // occur, 255 + positive value is still 255
+    return apply(best_kernels().encode, carrier, message);
+}
+
+Mat_<uchar> decode(const Mat_<uchar>& carrier, const Mat_<uchar>& encoded)
+{
+    if (carrier.size() != encoded.size())
+        throw error("Images have different dimension");
+
+    // putting 255 where (encoded - carrier) equals 0 and 0 where it equals 1
+    return apply(best_kernels().decode, carrier, encoded);
+}
+
+Mat_<uchar> encode(const Mat_<uchar>& carrier, const bit_plane& message)
+{
+    if (carrier.size() != message.size())
+        throw error("Images have different dimension");
+
+    Mat_<uchar> encoded(carrier.size());
+    for (int row = 0; row < carrier.rows; ++row) {
+        auto pixels = carrier[row];
+        auto words = message.row(row);
+        auto out = encoded[row];
+        for (int col = 0; col < carrier.cols; ++col) {
+            bool black = !(words[col / 64] >> (col % 64) & 1);
+            out[col] = uchar(pixels[col] + (black && pixels[col] < 255));
+        }
+    }
+    return encoded;
+}
+
+bit_plane decode_bits(const Mat_<uchar>& carrier, const Mat_<uchar>& encoded)
+{
+    if (carrier.size() != encoded.size())
+        throw error("Images have different dimension");
+
+    bit_plane decoded(carrier.size());
+    for (int row = 0; row < carrier.rows; ++row) {
+        auto carrier_pixels = carrier[row];
+        auto encoded_pixels = encoded[row];
+        auto words = decoded.row(row);
+        for (int first = 0; first < carrier.cols; first += 64) {
+            auto count = min(64, carrier.cols - first);
+            uint64_t word = 0;
+            for (int i = 0; i < count; ++i) {
+                bool white =
+                    encoded_pixels[first + i] <= carrier_pixels[first + i];
+                word |= uint64_t(white) << i;
+            }
+            words[first / 64] = word;
+        }
+    }
+    return decoded;
+}
+
+}  // namespace part_a
+}  // namespace stego
@@ -0,0 +1,98 @@
+// Steganography library - Part B (Scrambling the Signal)
+
+#include "stego/part_b.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace stego {
+namespace part_b {
+
+namespace {
+
+// generates a random shuffled vector of increasing indexes for all of the
+// points in an image
+vector<int> shuffled_indexes(Size size, seed_t seed)
+{
+    vector<int> indexes(size.area());
+    {  // I use block to limit scope of i
+        int i = 0;
+        for (auto& index : indexes)
+            index = i++;
+    }
+    RNG rng(seed);
+    shuffle(indexes.begin(), indexes.end(), rng);
+    return indexes;
+}
+
+}  // namespace
+
+Mat_<uchar> encode(const Mat_<uchar>& carrier, const bit_plane& message,
+                   seed_t seed)
+{
+    if (carrier.size() != message.size())
+        throw error("Images have different dimension");
+
+    auto indexes = shuffled_indexes(message.size(), seed);
+    Mat_<uchar> encoded = carrier.clone();  // continuous
+    auto encoded_data = encoded.ptr<uchar>();
+    auto index = indexes.begin();
+    for (int row = 0; row < message.rows(); ++row) {
+        auto words = message.row(row);
+        for (int col = 0; col < message.cols(); ++col) {
+            bool white = words[col / 64] >> (col % 64) & 1;
+            auto& encoded_pixel = encoded_data[*index++];
+            if (encoded_pixel != 255)  // preventing overflow
+                encoded_pixel += white ? 0 : 1;  // if pixel is black then
+                                                 // add 1
+        }
+    }
+    return encoded;
+}
+
+bit_plane decode_bits(const Mat_<uchar>& carrier, const Mat_<uchar>& encoded,
+                      seed_t seed)
+{
+    if (carrier.size() != encoded.size())
+        throw error("Images have different dimension");
+
+    auto indexes = shuffled_indexes(encoded.size(), seed);
+    bit_plane decoded(encoded.size());
+    auto cols = encoded.cols;
+    auto index = indexes.begin();
+    for (int row = 0; row < decoded.rows(); ++row) {
+        auto words = decoded.row(row);
+        // decoding a word (64 pixels) at a time
+        for (int first = 0; first < cols; first += 64) {
+            auto count = min(64, cols - first);
+            uint64_t word = 0;
+            for (int i = 0; i < count; ++i, ++index) {
+                auto y = *index / cols;
+                auto x = *index % cols;
+                word |= uint64_t(encoded(y, x) == carrier(y, x)) << i;
+            }
+            words[first / 64] = word;
+        }
+    }
+    return decoded;
+}
+
+Mat_<uchar> encode(const Mat_<uchar>& carrier, const Mat_<uchar>& message,
+                   seed_t seed)
+{
+    if (carrier.size() != message.size())
+        throw error("Images have different dimension");
+    return encode(carrier, bit_plane::from_image(message), seed);
+}
+
+Mat_<uchar> decode(const Mat_<uchar>& carrier, const Mat_<uchar>& encoded,
+                   seed_t seed)
+{
+    return decode_bits(carrier, encoded, seed).to_image();
+}
+
+}  // namespace part_b
+}  // namespace stego
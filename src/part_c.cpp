@@ -0,0 +1,25 @@
+// Steganography library - Part C (Generating Noise Images)
+
+#include "stego/part_c.h"
+#include "stego/noise.h"
+
+using namespace cv;
+
+namespace stego {
+namespace part_c {
+
+Mat_<Vec3b> noise(const Mat_<Vec3b>& image, seed_t seed, double sigma,
+                  noise_generator generator)
+{
+    Mat_<Vec3b> noised;
+    if (generator == noise_generator::legacy) {
+        RNG rng(seed);
+        add_gaussian_noise(image, noised, sigma, rng);
+    } else {
+        add_gaussian_noise(image, noised, sigma, seed, generator);
+    }
+    return noised;
+}
+
+}  // namespace part_c
+}  // namespace stego
@@ -0,0 +1,278 @@
+// Steganography library - Part D (Extending to Colour Images)
+
+#include "stego/part_d.h"
+#include "stego/permutation.h"
+#include "stego/report.h"
+#include "stego/slots.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace stego {
+namespace part_d {
+
+namespace {
+
+// sigma of Gaussian noise generated before choosing carrier bytes
+constexpr double sigma = 5;
+
+enum Used { NOT_USED, USED };
+
+// number of carrier bytes able to hold a message bit
+size_t count_free_bytes(const Mat_<Vec3b>& carrier)
+{
+    size_t count = 0;
+    for (auto& pixel : carrier)
+        for (auto i : {0, 1, 2})
+            count += pixel[i] < 255;
+    return count;
+}
+
+// uses the password seeded random number generator to select random
+// locations in the carrier image (must be not used before and lower than
+// 255), the generator is advanced past the noise generation stage first;
+// visit is called with the byte offset of every location as it is drawn
+// (carrier may be encoded in place meanwhile, used bytes are never drawn
+// again)
+template <typename Visit>
+void legacy_slots(const Mat_<Vec3b>& carrier, size_t count, seed_t seed,
+                  Visit visit)
+{
+    if (count > count_free_bytes(carrier))
+        throw error("Carrier image is too small");
+
+    // the noised image itself is not used, only one gaussian value per byte
+    // is drawn (as add_gaussian_noise does)
+    RNG rng(seed);
+    for (size_t i = 0; i < carrier.total() * 3; ++i)
+        rng.gaussian(sigma);
+
+    // one bit holds a state of every byte in carrier image
+    vector<bool> used(carrier.total() * 3);
+    uint64_t picks = 0;
+    for (size_t i = 0; i < count; ++i) {
+        int row, col, element;
+        size_t slot;
+        do {
+            row = rng(carrier.rows);
+            col = rng(carrier.cols);
+            element = rng(3);
+            slot = (size_t(row) * carrier.cols + col) * 3 + element;
+            ++picks;
+        } while (used[slot] || carrier(row, col)[element] == 255);
+        used[slot] = true;
+        visit(slot);
+    }
+    add(counter::slots_scanned, picks);
+    add(counter::retries, picks - count);
+}
+
+// partially shuffles byte offsets of all carrier bytes lower than 255, so
+// every bit costs the same no matter how full the carrier is
+template <typename Index, typename Visit>
+void permutation_slots(const Mat_<Vec3b>& carrier, size_t count, seed_t seed,
+                       Visit visit)
+{
+    auto slots = free_slots<Index>(carrier);
+    if (count > slots.size())
+        throw error("Carrier image is too small");
+
+    RNG rng(seed);
+    partial_shuffle(slots.begin(), slots.begin() + count, slots.end(), rng);
+    for (size_t i = 0; i < count; ++i)
+        visit(size_t(slots[i]));
+}
+
+// visits byte offsets (in continuous matrix) of carrier bytes holding
+// message bits, in order of use (32-bit offset table for carriers up to 4
+// GiB)
+template <typename Visit>
+void choose_slots(const Mat_<Vec3b>& carrier, size_t count, seed_t seed,
+                  order slot_order, Visit visit)
+{
+    if (slot_order == order::legacy)
+        legacy_slots(carrier, count, seed, visit);
+    else if (fits_32bit_slots(carrier))
+        permutation_slots<uint32_t>(carrier, count, seed, visit);
+    else
+        permutation_slots<uint64_t>(carrier, count, seed, visit);
+}
+
+// bits of message plane in row order, one at a time
+class message_bits {
+public:
+    explicit message_bits(const bit_plane& message) : message_(message) {}
+
+    // the next bit
+    bool next()
+    {
+        bool white = message_.row(row_)[col_ / 64] >> (col_ % 64) & 1;
+        if (++col_ == message_.cols()) {
+            col_ = 0;
+            ++row_;
+        }
+        return white;
+    }
+
+private:
+    const bit_plane& message_;
+    int row_ = 0;
+    int col_ = 0;
+};
+
+}  // namespace
+
+prepared_carrier prepare(const Mat_<Vec3b>& carrier, seed_t seed,
+                         order slot_order)
+{
+    prepared_carrier prepared{carrier.isContinuous() ? carrier
+                                                     : carrier.clone(),
+                              {}};
+    prepared.slots.reserve(carrier.total());
+    choose_slots(prepared.carrier, carrier.total(), seed, slot_order,
+                 [&](size_t slot) { prepared.slots.push_back(slot); });
+    return prepared;
+}
+
+void encode_in_place(Mat_<Vec3b>& carrier, const bit_plane& message,
+                     seed_t seed, order slot_order)
+{
+    if (carrier.size() != message.size())
+        throw error("Images have different dimensions");
+    if (!carrier.isContinuous())
+        carrier = carrier.clone();
+
+    // distributing message bits over the three colour carrier image chanels
+    // as the bytes are chosen
+    auto bytes = carrier.ptr<uchar>();
+    message_bits bits(message);
+    choose_slots(carrier, carrier.total(), seed, slot_order,
+                 [&](size_t slot) { bytes[slot] += bits.next() ? 0 : 1; });
+}
+
+Mat_<Vec3b> encode(const prepared_carrier& prepared, const bit_plane& message)
+{
+    if (prepared.carrier.size() != message.size())
+        throw error("Images have different dimensions");
+
+    // distributing message bits over the three colour carrier image chanels
+    // iterating through each location in the message image
+    Mat_<Vec3b> encoded = prepared.carrier.clone();
+    auto encoded_bytes = encoded.ptr<uchar>();
+    auto slot = prepared.slots.begin();
+    for (int row = 0; row < message.rows(); ++row) {
+        auto words = message.row(row);
+        for (int col = 0; col < message.cols(); ++col) {
+            // encoding message image bit
+            bool white = words[col / 64] >> (col % 64) & 1;
+            encoded_bytes[*slot++] += white ? 0 : 1;
+        }
+    }
+    return encoded;
+}
+
+bit_plane decode_bits(const prepared_carrier& prepared,
+                      const Mat_<Vec3b>& encoded)
+{
+    if (prepared.carrier.size() != encoded.size())
+        throw error("Images have different dimensions");
+
+    // reading message bits over the three colour carrier image chanels
+    // iterating through each location in the encoded image
+    Mat_<Vec3b> encoded_bytes = encoded.isContinuous() ? encoded
+                                                       : encoded.clone();
+    auto carrier_data = prepared.carrier.ptr<uchar>();
+    auto encoded_data = encoded_bytes.ptr<uchar>();
+    bit_plane decoded(encoded.size());
+    auto slot = prepared.slots.begin();
+    for (int row = 0; row < decoded.rows(); ++row) {
+        auto words = decoded.row(row);
+        // decoding a word (64 message image bits) at a time
+        for (int first = 0; first < decoded.cols(); first += 64) {
+            auto count = min(64, decoded.cols() - first);
+            uint64_t word = 0;
+            for (int i = 0; i < count; ++i, ++slot) {
+                bool white = encoded_data[*slot] - carrier_data[*slot] != 1;
+                word |= uint64_t(white) << i;
+            }
+            words[first / 64] = word;
+        }
+    }
+    return decoded;
+}
+
+Mat_<Vec3b> encode(const prepared_carrier& prepared,
+                   const Mat_<uchar>& message)
+{
+    if (prepared.carrier.size() != message.size())
+        throw error("Images have different dimensions");
+    return encode(prepared, bit_plane::from_image(message));
+}
+
+Mat_<uchar> decode(const prepared_carrier& prepared,
+                   const Mat_<Vec3b>& encoded)
+{
+    return decode_bits(prepared, encoded).to_image();
+}
+
+Mat_<Vec3b> encode(const Mat_<Vec3b>& carrier, const Mat_<uchar>& message,
+                   seed_t seed, order slot_order)
+{
+    if (carrier.size() != message.size())
+        throw error("Images have different dimensions");
+    return encode(carrier, bit_plane::from_image(message), seed, slot_order);
+}
+
+Mat_<uchar> decode(const Mat_<Vec3b>& carrier, const Mat_<Vec3b>& encoded,
+                   seed_t seed, order slot_order)
+{
+    if (carrier.size() != encoded.size())
+        throw error("Images have different dimensions");
+    return decode(prepare(carrier, seed, slot_order), encoded);
+}
+
+Mat_<Vec3b> encode(const Mat_<Vec3b>& carrier, const bit_plane& message,
+                   seed_t seed, order slot_order)
+{
+    Mat_<Vec3b> encoded = carrier.clone();  // the only full-size copy
+    encode_in_place(encoded, message, seed, slot_order);
+    return encoded;
+}
+
+bit_plane decode_bits(const Mat_<Vec3b>& carrier, const Mat_<Vec3b>& encoded,
+                      seed_t seed, order slot_order)
+{
+    if (carrier.size() != encoded.size())
+        throw error("Images have different dimensions");
+
+    // reading message bits as the bytes are chosen
+    Mat_<Vec3b> carrier_bytes = carrier.isContinuous() ? carrier
+                                                       : carrier.clone();
+    Mat_<Vec3b> encoded_bytes = encoded.isContinuous() ? encoded
+                                                       : encoded.clone();
+    auto carrier_data = carrier_bytes.ptr<uchar>();
+    auto encoded_data = encoded_bytes.ptr<uchar>();
+    bit_plane decoded(encoded.size());
+    int row = 0, col = 0;
+    uint64_t word = 0;
+    choose_slots(carrier_bytes, carrier.total(), seed, slot_order,
+                 [&](size_t slot) {
+                     bool white = encoded_data[slot] - carrier_data[slot] != 1;
+                     word |= uint64_t(white) << (col % 64);
+                     if (++col % 64 == 0 || col == decoded.cols()) {
+                         decoded.row(row)[(col - 1) / 64] = word;
+                         word = 0;
+                     }
+                     if (col == decoded.cols()) {
+                         col = 0;
+                         ++row;
+                     }
+                 });
+    return decoded;
+}
+
+}  // namespace part_d
+}  // namespace stego
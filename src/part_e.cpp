@@ -0,0 +1,1340 @@
+// Steganography library - Part E (General Information Hiding)
+
+#include "stego/part_e.h"
+#include "stego/compression.h"
+#include "stego/crc32c.h"
+#include "stego/image_io.h"
+#include "stego/noise.h"
+#include "stego/permutation.h"
+#include "stego/report.h"
+#include "stego/slots.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <istream>
+#include <ostream>
+#include <string>
+
+using namespace cv;
+using namespace std;
+
+namespace stego {
+namespace part_e {
+
+namespace {
+
+// thrown by slot_sequence when every free slot has been used
+struct out_of_slots {};
+
+// password seeded sequence of slots of prepared noised carrier image, given
+// as byte offsets in the (continuous) noised matrix; with LSB embeddings
+// every byte is a slot
+class slot_sequence {
+public:
+    // rng is taken over from prepared carrier, so it is left unchanged;
+    // bytes is the size of the carrier (prepared noised carrier is empty for
+    // blind decoding)
+    slot_sequence(const prepared_carrier& prepared, uint64_t bytes)
+        : prepared_(prepared),
+          rng_(prepared.rng),
+          chacha_(prepared.seed, slot_stream),
+          permutation_(
+              prepared.opts.slot_generator == random_generator::chacha
+                  ? lazy_permutation(bytes, chacha_)
+                  : lazy_permutation(bytes, rng_)),
+          every_byte_(prepared.opts.embed != embedding::additive)
+    {
+    }
+
+    ~slot_sequence() { add(counter::slots_scanned, scanned_); }
+
+    // throws out_of_slots when every free slot has been used
+    size_t next()
+    {
+        if (prepared_.opts.slot_order == order::legacy) {
+            const auto& narrow = prepared_.slots;
+            const auto& wide = prepared_.wide_slots;
+            if (slot_index_ == narrow.size() + wide.size())
+                throw out_of_slots();
+            auto index = slot_index_++;
+            ++scanned_;
+            return wide.empty() ? size_t(narrow[index]) : size_t(wide[index]);
+        }
+        if (every_byte_) {
+            if (permutation_.empty())
+                throw out_of_slots();
+            ++scanned_;
+            return size_t(permutation_.next());
+        }
+        // bytes which are not free (too close to 255 to be added to) are
+        // skipped
+        const auto bytes = prepared_.noised.ptr<uchar>();
+        const auto highest = 256 - (1 << prepared_.opts.bits);
+        while (!permutation_.empty()) {
+            auto offset = size_t(permutation_.next());
+            ++scanned_;
+            if (bytes[offset] <= highest)
+                return offset;
+        }
+        throw out_of_slots();
+    }
+
+private:
+    const prepared_carrier& prepared_;
+    RNG rng_;
+    chacha_rng chacha_;
+    lazy_permutation permutation_;
+    bool every_byte_;
+    size_t slot_index_ = 0;
+    uint64_t scanned_ = 0;
+};
+
+// changes byte at offset to hold a value of opts.bits bits
+class slot_embedder {
+public:
+    slot_embedder(const options& opts, seed_t seed)
+        : embed_(opts.embed),
+          mask_((1 << opts.bits) - 1),
+          key_(mix64(seed ^ 0x4C53424D41544348))  // "LSBMATCH"
+    {
+    }
+
+    void operator()(uchar* bytes, size_t offset, int value) const
+    {
+        auto& byte = bytes[offset];
+        switch (embed_) {
+        case embedding::additive:
+            byte += value;
+            break;
+        case embedding::lsb_replacement:
+            byte = uchar((byte & ~mask_) | value);
+            break;
+        case embedding::lsb_matching: {
+            if ((byte & mask_) == value)
+                break;
+            // the nearest byte value ending with value, ties (always for a
+            // single bit) broken at random; direction depends on seed and
+            // offset only, so bytes embedded in parallel give the same image
+            const int step = mask_ + 1;
+            int same_high = (byte & ~mask_) | value;
+            int lower = same_high > byte ? same_high - step : same_high;
+            int upper = lower + step;
+            bool up;
+            if (lower < 0)
+                up = true;
+            else if (upper > 255)
+                up = false;
+            else if (byte - lower != upper - byte)
+                up = upper - byte < byte - lower;
+            else
+                up = mix64(key_ ^ offset) & 1;
+            byte = uchar(up ? upper : lower);
+            break;
+        }
+        }
+    }
+
+private:
+    embedding embed_;
+    int mask_;
+    uint64_t key_;
+};
+
+// reads values hidden by slot_embedder (least significant bits when noised
+// is null, difference from the noised carrier otherwise); encoded rows may
+// be apart (caller buffers, submatrices), offsets are mapped to them
+class slot_extractor {
+public:
+    slot_extractor(const Mat_<Vec3b>& encoded, const uchar* noised, int bits)
+        : encoded_(encoded.ptr<uchar>()),
+          continuous_(encoded.isContinuous()),
+          row_bytes_(size_t(encoded.cols) * 3),
+          stride_(size_t(encoded.step)),
+          noised_(noised),
+          mask_((1 << bits) - 1)
+    {
+    }
+
+    int operator()(size_t offset) const
+    {
+        int byte = continuous_ ? encoded_[offset]
+                               : encoded_[offset / row_bytes_ * stride_ +
+                                          offset % row_bytes_];
+        return (noised_ ? byte - noised_[offset] : byte) & mask_;
+    }
+
+private:
+    const uchar* encoded_;
+    bool continuous_;
+    size_t row_bytes_;
+    size_t stride_;
+    const uchar* noised_;
+    int mask_;
+};
+
+// number of payload bytes whose slots are drawn (serially) before their bits
+// are embedded or extracted in parallel
+constexpr size_t chunk_bytes = 1 << 16;
+
+// number of extracted bytes checksummed by one parallel task, the checksums
+// of a chunk being combined afterwards
+constexpr size_t crc_block = 1 << 10;
+
+// number of slots holding count bytes, bits bits per slot (the last one may
+// be filled partly)
+size_t slots_for(size_t count, int bits)
+{
+    return (count * 8 + bits - 1) / bits;
+}
+
+// number of payload bytes held by slots, chunk by chunk (every chunk
+// starting at a new slot)
+uint64_t bytes_held(uint64_t slots, int bits)
+{
+    const uint64_t chunk_slots = slots_for(chunk_bytes, bits);
+    return slots / chunk_slots * chunk_bytes + slots % chunk_slots * bits / 8;
+}
+
+// number of slots among count noised bytes: every byte with LSB embeddings,
+// bytes leaving room for the hidden bits with additive embedding
+uint64_t slot_count(const uchar* noised, uint64_t count,
+                    const options& opts)
+{
+    if (opts.embed != embedding::additive)
+        return count;
+    const auto highest = 256 - (1 << opts.bits);
+    return uint64_t(count_if(noised, noised + count,
+                             [=](uchar byte) { return byte <= highest; }));
+}
+
+// offsets of the slots of one piece, 32-bit for images up to 4 GiB (halving
+// the memory of the largest per-chunk table)
+class slot_offsets {
+public:
+    // bytes is the size of the image
+    explicit slot_offsets(uint64_t bytes) : wide_(bytes > UINT32_MAX) {}
+
+    // draws the next count slots
+    template <typename Slots>
+    void draw(Slots& slots, size_t count)
+    {
+        if (wide_) {
+            wide_slots_.resize(count);
+            for (auto& slot : wide_slots_)
+                slot = slots.next();
+        } else {
+            narrow_slots_.resize(count);
+            for (auto& slot : narrow_slots_)
+                slot = uint32_t(slots.next());
+        }
+    }
+
+    size_t size() const
+    {
+        return wide_ ? wide_slots_.size() : narrow_slots_.size();
+    }
+
+    size_t operator[](size_t i) const
+    {
+        return wide_ ? size_t(wide_slots_[i]) : size_t(narrow_slots_[i]);
+    }
+
+private:
+    bool wide_;
+    vector<uint32_t> narrow_slots_;
+    vector<uint64_t> wide_slots_;
+};
+
+// hides bits of payload bytes in slots, bits bits per slot visit: slot s
+// holds bits [s * bits, (s + 1) * bits) of the payload, where bit 8 * i + j
+// is the j-th bit of i-th byte
+class embed_bytes : public ParallelLoopBody {
+public:
+    embed_bytes(uchar* encoded, const slot_offsets& slots, const char* data,
+                size_t count, int bits, const slot_embedder& embed)
+        : encoded_(encoded),
+          slots_(slots),
+          data_(data),
+          count_(count),
+          bits_(bits),
+          embed_(embed)
+    {
+    }
+
+    void operator()(const Range& slots) const override
+    {
+        for (int s = slots.start; s < slots.end; ++s) {
+            int value = 0;
+            for (int t = 0; t < bits_; ++t) {
+                auto bit = size_t(s) * bits_ + t;
+                if (bit < count_ * 8)
+                    value |= get_bit(data_[bit / 8], unsigned(bit % 8)) << t;
+            }
+            embed_(encoded_, slots_[s], value);
+        }
+    }
+
+private:
+    uchar* encoded_;
+    const slot_offsets& slots_;
+    const char* data_;
+    size_t count_;
+    int bits_;
+    const slot_embedder& embed_;
+};
+
+// reads bits of payload bytes hidden by embed_bytes, crc_block bytes per
+// task, storing checksums of full blocks to block_crcs (when not null)
+class extract_bytes : public ParallelLoopBody {
+public:
+    extract_bytes(const slot_extractor& extract, const slot_offsets& slots,
+                  char* data, size_t count, int bits, uint32_t* block_crcs)
+        : extract_(extract), slots_(slots), data_(data), count_(count),
+          bits_(bits), block_crcs_(block_crcs)
+    {
+    }
+
+    void operator()(const Range& blocks) const override
+    {
+        for (int block = blocks.start; block < blocks.end; ++block) {
+            auto first = size_t(block) * crc_block;
+            auto last = min(first + crc_block, count_);
+            for (auto i = first; i < last; ++i)
+                read_byte(i);
+            if (block_crcs_ && last - first == crc_block)
+                block_crcs_[block] = crc32c(data_ + first, crc_block);
+        }
+    }
+
+private:
+    void read_byte(size_t i) const
+    {
+        auto bit = i * 8;
+        auto slot = bit / bits_;
+        auto value = extract_(slots_[slot]) >> (bit % bits_);
+        auto left = bits_ - int(bit % bits_);  // bits of value not read
+        for (unsigned j = 0; j < 8; ++j) {
+            if (!left) {
+                value = extract_(slots_[++slot]);
+                left = bits_;
+            }
+            set_bit(data_[i], j, value & 1);
+            value >>= 1;
+            --left;
+        }
+    }
+
+    const slot_extractor& extract_;
+    const slot_offsets& slots_;
+    char* data_;
+    size_t count_;
+    int bits_;
+    uint32_t* block_crcs_;
+};
+
+// draws the next slots of count bytes (starting at a new slot)
+template <typename Slots>
+void draw_piece(Slots& slots, size_t count, int bits,
+                slot_offsets& piece_slots)
+{
+    piece_slots.draw(slots, slots_for(count, bits));
+}
+
+// hides count bytes of data in slots drawn by draw_piece
+void embed_drawn(uchar* encoded, const slot_offsets& piece_slots,
+                 const char* data, size_t count, int bits,
+                 const slot_embedder& embed)
+{
+    parallel_for_(Range(0, int(piece_slots.size())),
+                  embed_bytes(encoded, piece_slots, data, count, bits,
+                              embed));
+}
+
+// hides count bytes of data in the next slots
+template <typename Slots>
+void embed_piece(uchar* encoded, Slots& slots, const char* data, size_t count,
+                 int bits, const slot_embedder& embed,
+                 slot_offsets& piece_slots)
+{
+    draw_piece(slots, count, bits, piece_slots);
+    embed_drawn(encoded, piece_slots, data, count, bits, embed);
+}
+
+// reads count bytes hidden by embed_piece, continuing checksum crc (when not
+// null) with them
+template <typename Slots>
+void extract_piece(const slot_extractor& extract, Slots& slots,
+                   char* data, size_t count, int bits,
+                   slot_offsets& piece_slots, uint32_t* crc = nullptr)
+{
+    draw_piece(slots, count, bits, piece_slots);
+    const auto blocks = (count + crc_block - 1) / crc_block;
+    vector<uint32_t> block_crcs(crc ? blocks : 0);
+    parallel_for_(Range(0, int(blocks)),
+                  extract_bytes(extract, piece_slots, data, count, bits,
+                                crc ? block_crcs.data() : nullptr));
+    if (!crc)
+        return;
+
+    static const crc32c_combiner next_block(crc_block);
+    const auto full = count / crc_block;
+    for (size_t block = 0; block < full; ++block)
+        *crc = next_block(*crc, block_crcs[block]);
+    *crc = crc32c(data + full * crc_block, count - full * crc_block, *crc);
+}
+
+// throws stego::error on options no encoder or decoder accepts
+void check(const options& opts)
+{
+    if (opts.bits < 1 || opts.bits > 4)
+        throw error("Bits per slot must be 1 to 4");
+    if (opts.slot_order == order::legacy) {
+        if (opts.embed != embedding::additive)
+            throw error("LSB embedding needs permutation order");
+        if (opts.bits != 1)
+            throw error("Multiple bits per slot need permutation order");
+    }
+    if (opts.compress != compression::none && !opts.payload_header)
+        throw error("Compression needs payload header");
+}
+
+// versioned payload header hidden after the seed (fields little-endian):
+//   bytes  0-3   "STGP"
+//   byte   4     version (1)
+//   byte   5     algorithm of the hidden payload (stego::compression id,
+//                0: stored as is)
+//   bytes  6-7   zero
+//   bytes  8-15  payload size (as hidden, so compressed size)
+//   bytes 16-19  CRC32C of the payload (as hidden)
+//   bytes 20-23  CRC32C of bytes 0-19
+// so that wrong carriers and corrupted images are rejected once the seed and
+// these 24 bytes are read
+constexpr char payload_magic[4] = {'S', 'T', 'G', 'P'};
+constexpr uint8_t payload_version = 1;
+constexpr size_t payload_header_bytes = 24;
+
+struct payload_header {
+    compression algorithm = compression::none;
+    uint64_t size = 0;
+    uint32_t crc = 0;
+};
+
+vector<char> payload_piece(const payload_header& header)
+{
+    vector<char> piece(payload_header_bytes);
+    auto put = [&](size_t at, uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i)
+            piece[at + i] = char(value >> (8 * i));
+    };
+    copy(begin(payload_magic), end(payload_magic), piece.begin());
+    piece[4] = char(payload_version);
+    piece[5] = char(uint8_t(header.algorithm));
+    put(8, header.size, 8);
+    put(16, header.crc, 4);
+    put(20, crc32c(piece.data(), 20), 4);
+    return piece;
+}
+
+// throws stego::error on corrupted header or one of unknown version or
+// algorithm
+payload_header read_payload_header(const vector<char>& piece)
+{
+    auto get = [&](size_t at, int bytes) {
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; ++i)
+            value |= uint64_t(uchar(piece[at + i])) << (8 * i);
+        return value;
+    };
+    if (!equal(begin(payload_magic), end(payload_magic), piece.begin()) ||
+        uint32_t(get(20, 4)) != crc32c(piece.data(), 20))
+        throw error("Corrupted payload header");
+    if (uchar(piece[4]) != payload_version)
+        throw error("Unsupported payload version " +
+                    to_string(int(uchar(piece[4]))));
+    payload_header header;
+    auto algorithm = uchar(piece[5]);
+    if (algorithm > uint8_t(last_compression))
+        throw error("Unsupported payload algorithm " +
+                    to_string(int(algorithm)));
+    header.algorithm = compression(algorithm);
+    header.size = get(8, 8);
+    header.crc = uint32_t(get(16, 4));
+    return header;
+}
+
+// prepares carrier noised into noised: a new matrix when empty, otherwise
+// continuous matrix of carrier size (caller buffer, or carrier itself)
+prepared_carrier prepare_into(const Mat_<Vec3b>& carrier,
+                              const Mat_<Vec3b>& noised, seed_t seed,
+                              const options& opts)
+{
+    check(opts);
+
+    prepared_carrier prepared{noised, RNG(seed), seed, opts, {}, {}};
+    // legacy generator advances rng (which later shuffles slots) past the
+    // noise generation stage
+    if (opts.noise == noise_generator::legacy)
+        add_gaussian_noise(carrier, prepared.noised, sigma, prepared.rng);
+    else
+        add_gaussian_noise(carrier, prepared.noised, sigma, seed, opts.noise);
+    // blind decoder has no carrier to noise, so slots are drawn from a fresh
+    // generator
+    if (opts.embed != embedding::additive)
+        prepared.rng = RNG(seed);
+
+    if (opts.slot_order == order::legacy) {
+        // counting number of slots in noised carrier image and random
+        // shuffling them (64-bit offsets only for carriers over 4 GiB)
+        auto shuffle_slots = [&](auto& slots) {
+            if (opts.slot_generator == random_generator::chacha) {
+                chacha_rng rng(seed, slot_stream);
+                shuffle(slots.begin(), slots.end(), rng);
+            } else {
+                shuffle(slots.begin(), slots.end(), prepared.rng);
+            }
+        };
+        if (fits_32bit_slots(prepared.noised)) {
+            prepared.slots = free_slots<uint32_t>(prepared.noised);
+            shuffle_slots(prepared.slots);
+        } else {
+            prepared.wide_slots = free_slots<uint64_t>(prepared.noised);
+            shuffle_slots(prepared.wide_slots);
+        }
+    }
+    return prepared;
+}
+
+}  // namespace
+
+prepared_carrier prepare(const Mat_<Vec3b>& carrier, seed_t seed,
+                         const options& opts)
+{
+    return prepare_into(carrier, Mat_<Vec3b>(), seed, opts);
+}
+
+prepared_carrier prepare_in_place(Mat_<Vec3b>& carrier, seed_t seed,
+                                  const options& opts)
+{
+    if (!carrier.isContinuous())
+        carrier = carrier.clone();
+    return prepare_into(carrier, carrier, seed, opts);
+}
+
+uint64_t capacity(const prepared_carrier& prepared)
+{
+    const auto& opts = prepared.opts;
+    const auto& noised = prepared.noised;
+
+    // counting slots
+    uint64_t slots;
+    if (opts.slot_order == order::legacy) {
+        slots = prepared.slots.size() + prepared.wide_slots.size();
+    } else {
+        slots = slot_count(noised.ptr<uchar>(), noised.total() * 3, opts);
+    }
+
+    // taking away slots of seed and size pieces, every piece (and so every
+    // data chunk) starting at a new slot
+    uint64_t header_slots =
+        slots_for(sizeof(seed_t), opts.bits) +
+        slots_for(opts.payload_header ? payload_header_bytes
+                  : opts.wide_size    ? sizeof(uint64_t)
+                                      : sizeof(int32_t),
+                  opts.bits);
+    if (slots <= header_slots)
+        return 0;
+    auto bytes = bytes_held(slots - header_slots, opts.bits);
+    return opts.wide_size ? bytes : min<uint64_t>(bytes, INT32_MAX);
+}
+
+uint64_t capacity(const Mat_<Vec3b>& carrier, seed_t seed, const options& opts)
+{
+    return capacity(prepare(carrier, seed, opts));
+}
+
+namespace {
+
+// header pieces: seed (for password checking) and message file size, each
+// bit i of a value going to bit i % 8 of byte i / 8
+template <typename T>
+vector<char> header_piece(const T& value)
+{
+    vector<char> piece(sizeof(T));
+    for (unsigned i = 0; i < sizeof(T) * 8; ++i)
+        set_bit(piece[i / 8], i % 8, get_bit(value, i));
+    return piece;
+}
+
+template <typename T>
+T header_value(const vector<char>& piece)
+{
+    T value = 0;
+    for (unsigned i = 0; i < sizeof(T) * 8; ++i)
+        set_bit(value, i, get_bit(piece[i / 8], i % 8));
+    return value;
+}
+
+// hides seed, size and size bytes produced by read (chunk by chunk) in
+// encoded, a copy of (or the very same matrix as) prepared noised carrier;
+// every piece (seed, size, chunk) starts at a new slot; compressed payloads
+// are hidden in chunks of compressor output, so the hidden size is known
+// only once the whole file has been read
+Mat_<Vec3b> encode(const prepared_carrier& prepared, Mat_<Vec3b> encoded,
+                   uint64_t size, const function<void(char*, size_t)>& read)
+{
+    const auto& opts = prepared.opts;
+    const auto seed = prepared.seed;
+    if (!opts.wide_size && size > INT32_MAX)
+        throw error("Message file is too big");
+
+    slot_sequence slots(prepared, encoded.total() * 3);
+    slot_embedder embed(opts, seed);
+    auto encoded_bytes = encoded.ptr<uchar>();
+    slot_offsets piece_slots(encoded.total() * 3);
+    auto hide = [&](const char* data, size_t count) {
+        embed_piece(encoded_bytes, slots, data, count, opts.bits, embed,
+                    piece_slots);
+    };
+
+    try {
+        // hiding seed variable (for password checking)
+        auto seed_piece = header_piece(seed);
+        hide(seed_piece.data(), seed_piece.size());
+
+        // reserving slots of payload header, which is hidden once the
+        // payload checksum is known (or hiding bare message file size)
+        slot_offsets header_slots(encoded.total() * 3);
+        if (opts.payload_header) {
+            draw_piece(slots, payload_header_bytes, opts.bits, header_slots);
+        } else {
+            auto size_piece = opts.wide_size ? header_piece(size)
+                                             : header_piece(int32_t(size));
+            hide(size_piece.data(), size_piece.size());
+        }
+
+        // distributing message bits over carrier image bytes, chunk by
+        // chunk; slots are distinct so they are embedded in parallel
+        uint64_t stored = 0;
+        uint32_t crc = 0;
+        auto hide_stored = [&](const char* data, size_t count) {
+            crc = crc32c(data, count, crc);
+            hide(data, count);
+            stored += count;
+        };
+        // compressor output is gathered into whole chunks, as decoder reads
+        // them (uncompressed chunks are hidden as they are read)
+        vector<char> pending;
+        auto store = [&](const char* data, size_t count) {
+            while (count) {
+                if (pending.empty() && count >= chunk_bytes) {
+                    hide_stored(data, chunk_bytes);
+                    data += chunk_bytes;
+                    count -= chunk_bytes;
+                    continue;
+                }
+                auto taken = min(count, chunk_bytes - pending.size());
+                pending.insert(pending.end(), data, data + taken);
+                data += taken;
+                count -= taken;
+                if (pending.size() == chunk_bytes) {
+                    hide_stored(pending.data(), pending.size());
+                    pending.clear();
+                }
+            }
+        };
+        compressor deflater(opts.compress);
+        vector<char> chunk(size_t(min<uint64_t>(chunk_bytes, size)));
+        for (uint64_t first = 0; first < size; first += chunk_bytes) {
+            auto count = size_t(min<uint64_t>(chunk_bytes, size - first));
+            read(chunk.data(), count);
+            deflater.write(chunk.data(), count, store);
+        }
+        deflater.finish(store);
+        if (!pending.empty())
+            hide_stored(pending.data(), pending.size());
+
+        if (opts.payload_header) {
+            payload_header header;
+            header.algorithm = opts.compress;
+            header.size = stored;
+            header.crc = crc;
+            auto piece = payload_piece(header);
+            embed_drawn(encoded_bytes, header_slots, piece.data(),
+                        piece.size(), opts.bits, embed);
+        }
+    } catch (const out_of_slots&) {
+        // determining if message, its size information and seed (for
+        // password checking) fit in the carrier image
+        throw error("Message file is too big");
+    }
+
+    return encoded;
+}
+
+// reads file hidden in encoded image; payload header (synthesised for
+// images without one) is reported to begin (after password is verified) and
+// the file, decompressed while it is read, to write, chunk by chunk; returns
+// file size; prepared noised carrier is not used (and empty for blind
+// decoding) with LSB embeddings
+uint64_t decode(const prepared_carrier& prepared, const Mat_<Vec3b>& encoded,
+                const function<void(const payload_header&)>& begin,
+                const function<void(const char*, size_t)>& write)
+{
+    const auto& noised = prepared.noised;
+    const auto& opts = prepared.opts;
+    const auto seed = prepared.seed;
+    const bool blind = opts.embed != embedding::additive;
+    if (!noised.empty() && noised.size() != encoded.size())
+        throw error("Images have different dimensions");
+
+    slot_sequence slots(prepared, encoded.total() * 3);
+    slot_extractor extract(encoded, blind ? nullptr : noised.ptr<uchar>(),
+                           opts.bits);
+    slot_offsets piece_slots(encoded.total() * 3);
+    auto read = [&](char* data, size_t count, uint32_t* crc = nullptr) {
+        extract_piece(extract, slots, data, count, opts.bits, piece_slots,
+                      crc);
+    };
+
+    try {
+        // reading seed variable (for password checking)
+        vector<char> seed_piece(sizeof(seed));
+        read(seed_piece.data(), seed_piece.size());
+        if (header_value<seed_t>(seed_piece) != seed)
+            throw error("Wrong password");
+
+        // reading payload header (or bare message file size)
+        payload_header header;
+        if (opts.payload_header) {
+            vector<char> piece(payload_header_bytes);
+            read(piece.data(), piece.size());
+            header = read_payload_header(piece);
+        } else if (opts.wide_size) {
+            vector<char> size_piece(sizeof(uint64_t));
+            read(size_piece.data(), size_piece.size());
+            header.size = header_value<uint64_t>(size_piece);
+        } else {
+            vector<char> size_piece(sizeof(int32_t));
+            read(size_piece.data(), size_piece.size());
+            auto narrow_size = header_value<int32_t>(size_piece);
+            header.size = narrow_size < 0 ? UINT64_MAX : narrow_size;
+        }
+        const auto stored = header.size;
+        if (stored > encoded.total() * 3 * opts.bits / 8)
+            throw error("Corrupted message file size");
+        begin(header);
+
+        // reading message bits, chunk by chunk in parallel, checking them
+        // against the payload checksum (computed by the same tasks)
+        decompressor inflater(header.algorithm);
+        uint64_t file_size = 0;
+        auto output = [&](const char* data, size_t count) {
+            write(data, count);
+            file_size += count;
+        };
+        vector<char> chunk(size_t(min<uint64_t>(chunk_bytes, stored)));
+        uint32_t crc = 0;
+        for (uint64_t first = 0; first < stored; first += chunk_bytes) {
+            auto count = size_t(min<uint64_t>(chunk_bytes, stored - first));
+            read(chunk.data(), count, &crc);
+            inflater.write(chunk.data(), count, output);
+        }
+        if (opts.payload_header && crc != header.crc)
+            throw error("Corrupted message file (checksum mismatch)");
+        if (header.algorithm != compression::none && !inflater.finished())
+            throw error("Corrupted compressed message file");
+        return file_size;
+    } catch (const out_of_slots&) {
+        throw error("Wrong password");
+    }
+}
+
+}  // namespace
+
+Mat_<Vec3b> encode(const prepared_carrier& prepared, const char* data,
+                   size_t size)
+{
+    return encode(prepared, prepared.noised.clone(), size,
+                  [&](char* chunk, size_t count) {
+                      copy(data, data + count, chunk);
+                      data += count;
+                  });
+}
+
+Mat_<Vec3b> encode(const prepared_carrier& prepared, istream& file,
+                   uint64_t size)
+{
+    return encode(prepared, prepared.noised.clone(), size,
+                  [&](char* chunk, size_t count) {
+                      if (!file.read(chunk, count))
+                          throw error("Could not read message file");
+                      add(counter::bytes_read, count);
+                  });
+}
+
+Mat_<Vec3b> encode_in_place(prepared_carrier& prepared, const char* data,
+                            size_t size)
+{
+    return encode(prepared, prepared.noised, size,
+                  [&](char* chunk, size_t count) {
+                      copy(data, data + count, chunk);
+                      data += count;
+                  });
+}
+
+Mat_<Vec3b> encode_in_place(prepared_carrier& prepared, istream& file,
+                            uint64_t size)
+{
+    return encode(prepared, prepared.noised, size,
+                  [&](char* chunk, size_t count) {
+                      if (!file.read(chunk, count))
+                          throw error("Could not read message file");
+                      add(counter::bytes_read, count);
+                  });
+}
+
+vector<char> decode(const prepared_carrier& prepared,
+                    const Mat_<Vec3b>& encoded)
+{
+    vector<char> memblock;
+    decode(prepared, encoded,
+           [&](const payload_header& header) {
+               // compressed size only, a lower bound of file size
+               memblock.reserve(size_t(header.size));
+           },
+           [&](const char* chunk, size_t count) {
+               memblock.insert(memblock.end(), chunk, chunk + count);
+           });
+    return memblock;
+}
+
+uint64_t decode(const prepared_carrier& prepared, const Mat_<Vec3b>& encoded,
+                ostream& file)
+{
+    return decode(prepared, encoded, [](const payload_header&) {},
+                  [&](const char* chunk, size_t count) {
+                      if (!file.write(chunk, count))
+                          throw error("Could not write decoded message");
+                      add(counter::bytes_written, count);
+                  });
+}
+
+Mat_<Vec3b> encode(const Mat_<Vec3b>& carrier, const char* data, size_t size,
+                   seed_t seed, const options& opts)
+{
+    auto prepared = prepare(carrier, seed, opts);
+    // noised carrier is not needed afterwards, so it is modified in place
+    return encode(prepared, prepared.noised, size,
+                  [&](char* chunk, size_t count) {
+                      copy(data, data + count, chunk);
+                      data += count;
+                  });
+}
+
+Mat_<Vec3b> encode(const Mat_<Vec3b>& carrier, istream& file, uint64_t size,
+                   seed_t seed, const options& opts)
+{
+    auto prepared = prepare(carrier, seed, opts);
+    return encode(prepared, prepared.noised, size,
+                  [&](char* chunk, size_t count) {
+                      if (!file.read(chunk, count))
+                          throw error("Could not read message file");
+                      add(counter::bytes_read, count);
+                  });
+}
+
+vector<char> decode(const Mat_<Vec3b>& carrier, const Mat_<Vec3b>& encoded,
+                    seed_t seed, const options& opts)
+{
+    if (carrier.size() != encoded.size())
+        throw error("Images have different dimensions");
+    return decode(prepare(carrier, seed, opts), encoded);
+}
+
+uint64_t decode(const Mat_<Vec3b>& carrier, const Mat_<Vec3b>& encoded,
+                ostream& file, seed_t seed, const options& opts)
+{
+    if (carrier.size() != encoded.size())
+        throw error("Images have different dimensions");
+    return decode(prepare(carrier, seed, opts), encoded, file);
+}
+
+namespace {
+
+prepared_carrier blind_prepared(seed_t seed, const options& opts)
+{
+    check(opts);
+    if (opts.slot_order == order::legacy)
+        throw error("LSB embedding needs permutation order");
+    auto blind_opts = opts;
+    blind_opts.embed = embedding::lsb_matching;
+    return {Mat_<Vec3b>(), RNG(seed), seed, blind_opts, {}, {}};
+}
+
+}  // namespace
+
+vector<char> decode_blind(const Mat_<Vec3b>& encoded, seed_t seed,
+                          const options& opts)
+{
+    return decode(blind_prepared(seed, opts), encoded);
+}
+
+uint64_t decode_blind(const Mat_<Vec3b>& encoded, ostream& file, seed_t seed,
+                      const options& opts)
+{
+    return decode(blind_prepared(seed, opts), encoded, file);
+}
+
+namespace {
+
+// 3-channel matrix over caller buffer
+Mat_<Vec3b> color_image(const pixel_view& view)
+{
+    if (view.channels != 3)
+        throw error("Carrier and encoded images must have 3 channels");
+    return Mat_<Vec3b>(wrap(view));
+}
+
+// rows of a strided image moved next to each other (in place) for the
+// lifetime of this object, since slots are offsets into continuous images;
+// moved back to their places afterwards
+class packed_rows {
+public:
+    // keep_content false: rows are to be overwritten, so they are not moved
+    packed_rows(const Mat_<Vec3b>& image, bool keep_content)
+        : image_(image), packed_(image)
+    {
+        if (image.isContinuous())
+            return;
+        auto row_bytes = size_t(image.cols) * 3;
+        auto first = image_.ptr<uchar>();
+        if (keep_content)
+            for (int row = 1; row < image.rows; ++row)
+                memmove(first + row * row_bytes, image_.ptr<uchar>(row),
+                        row_bytes);
+        packed_ = Mat_<Vec3b>(image.rows, image.cols, (Vec3b*)first);
+    }
+
+    ~packed_rows()
+    {
+        if (image_.isContinuous())
+            return;
+        auto row_bytes = size_t(image_.cols) * 3;
+        auto first = image_.ptr<uchar>();
+        for (int row = image_.rows - 1; row > 0; --row)
+            memmove(image_.ptr<uchar>(row), first + row * row_bytes,
+                    row_bytes);
+    }
+
+    packed_rows(const packed_rows&) = delete;
+    packed_rows& operator=(const packed_rows&) = delete;
+
+    const Mat_<Vec3b>& image() const { return packed_; }
+
+private:
+    Mat_<Vec3b> image_;
+    Mat_<Vec3b> packed_;
+};
+
+// decodes into out of capacity bytes, returns message size; size of
+// compressed messages is known only while they are decompressed, so they
+// are checked chunk by chunk
+uint64_t decode_into(const prepared_carrier& prepared,
+                     const Mat_<Vec3b>& encoded, char* out, size_t capacity)
+{
+    auto too_small = [](const string& size) {
+        return error("Output buffer is too small (message has " + size +
+                     " bytes)");
+    };
+    return decode(prepared, encoded,
+                  [&](const payload_header& header) {
+                      if (header.algorithm == compression::none &&
+                          header.size > capacity)
+                          throw too_small(to_string(header.size));
+                  },
+                  [&](const char* chunk, size_t count) {
+                      if (count > capacity)
+                          throw too_small("more than " +
+                                          to_string(capacity));
+                      out = copy(chunk, chunk + count, out);
+                      capacity -= count;
+                  });
+}
+
+}  // namespace
+
+void encode(const pixel_view& carrier, const pixel_buffer& encoded,
+            const char* data, size_t size, seed_t seed, const options& opts)
+{
+    auto source = color_image(carrier);
+    auto output = color_image(encoded);
+    if (source.size() != output.size())
+        throw error("Images have different dimensions");
+
+    // encoding in place packs carrier rows together with the output rows
+    const bool in_place = carrier.data == encoded.data;
+    packed_rows packed(output, in_place);
+    auto prepared = prepare_into(in_place ? packed.image() : source,
+                                 packed.image(), seed, opts);
+    encode(prepared, prepared.noised, size, [&](char* chunk, size_t count) {
+        copy(data, data + count, chunk);
+        data += count;
+    });
+}
+
+uint64_t decode(const pixel_view& carrier, const pixel_view& encoded,
+                char* out, size_t capacity, seed_t seed, const options& opts)
+{
+    auto carrier_image = color_image(carrier);
+    auto encoded_image = color_image(encoded);
+    if (carrier_image.size() != encoded_image.size())
+        throw error("Images have different dimensions");
+    return decode_into(prepare(carrier_image, seed, opts), encoded_image, out,
+                       capacity);
+}
+
+uint64_t decode_blind(const pixel_view& encoded, char* out, size_t capacity,
+                      seed_t seed, const options& opts)
+{
+    return decode_into(blind_prepared(seed, opts), color_image(encoded), out,
+                       capacity);
+}
+
+namespace {
+
+// bytes of a band of a tiled image (whole rows, at least one)
+constexpr size_t band_bytes = size_t(1) << 22;
+
+// throws stego::error when a row is too long for the 32-bit offsets of
+// band_slots
+int band_rows(int cols)
+{
+    if (uint64_t(cols) * 3 > UINT32_MAX)
+        throw error("Tiled images must have rows under 4 GiB");
+    return int(max<size_t>(1, band_bytes / (size_t(cols) * 3)));
+}
+
+// slots of one band of a tiled image, drawn from a Fisher-Yates shuffle of
+// the band bytes keyed by the ChaCha stream of the band, one step per slot
+// (the same sequence as lazy_permutation); the shuffle runs over order, an
+// array of band offsets reused by every band, so memory is 4 bytes per band
+// byte whatever the file size; with additive embedding bytes which are not
+// free are skipped (noised is null with LSB embeddings)
+class band_slots {
+public:
+    band_slots(const uchar* noised, uint64_t bytes, seed_t seed, int band,
+               const options& opts, vector<uint32_t>& order)
+        : noised_(noised),
+          rng_(seed, tile_stream + uint64_t(band)),
+          order_(order),
+          highest_(256 - (1 << opts.bits))
+    {
+        order_.resize(size_t(bytes));
+        iota(order_.begin(), order_.end(), uint32_t(0));
+    }
+
+    ~band_slots() { add(counter::slots_scanned, scanned_); }
+
+    // throws out_of_slots when every free slot has been used
+    size_t next()
+    {
+        while (position_ < order_.size()) {
+            auto chosen = position_ + size_t(uniform(
+                                          rng_, order_.size() - position_));
+            swap(order_[position_], order_[chosen]);
+            auto offset = size_t(order_[position_++]);
+            ++scanned_;
+            if (!noised_ || noised_[offset] <= highest_)
+                return offset;
+        }
+        throw out_of_slots();
+    }
+
+private:
+    const uchar* noised_;
+    chacha_rng rng_;
+    vector<uint32_t>& order_;
+    size_t position_ = 0;
+    int highest_;
+    uint64_t scanned_ = 0;
+};
+
+// first byte of the file held by the band starting at row (of rows),
+// size * row / rows rounded down without overflowing: bands hold shares of
+// the file in proportion to their rows, whatever their free slots
+uint64_t share_start(uint64_t size, int row, int rows)
+{
+    return size / rows * row + size % rows * uint64_t(row) / rows;
+}
+
+// number of file bytes noised band b holds (after seed and payload header or
+// file size in the first band)
+uint64_t band_capacity(const Mat_<Vec3b>& noised, int b, const options& opts)
+{
+    auto slots = slot_count(noised.ptr<uchar>(), noised.total() * 3, opts);
+    if (b == 0) {
+        auto header_slots =
+            slots_for(sizeof(seed_t), opts.bits) +
+            slots_for(opts.payload_header ? payload_header_bytes
+                                          : sizeof(uint64_t),
+                      opts.bits);
+        slots -= min(slots, uint64_t(header_slots));
+    }
+    return bytes_held(slots, opts.bits);
+}
+
+// largest file size whose share (of band_rows rows in an image of rows rows)
+// fits in capacity: shares of size * band_rows / rows bytes or less never
+// exceed it
+uint64_t share_limit(uint64_t capacity, int band_rows, int rows)
+{
+    return capacity / band_rows * rows +
+           capacity % band_rows * uint64_t(rows) / band_rows;
+}
+
+// throws stego::error on options the tiled engine does not accept
+void check_tiled(const options& opts)
+{
+    check(opts);
+    if (opts.slot_order != order::permutation ||
+        opts.slot_generator != random_generator::chacha ||
+        opts.noise == noise_generator::legacy || !opts.wide_size)
+        throw error("Tiled processing needs permutation order, ChaCha slots "
+                    "and counter-based noise");
+    // every band holds a share of the file, so its size must be known
+    // before the first band is encoded
+    if (opts.compress != compression::none)
+        throw error("Tiled processing does not compress payloads");
+}
+
+// throws stego::error unless image has 3 channels
+void check_color(const raw_reader& image, const string& path)
+{
+    if (image.type() != CV_8UC3)
+        throw error(path + " must have 3 channels");
+}
+
+// noises band of rows starting at first_row of an image of cols columns,
+// the same way the whole image is noised
+void noise_band(Mat_<Vec3b>& band, int first_row, int cols, seed_t seed,
+                const options& opts)
+{
+    add_gaussian_noise(band, band, sigma, seed, opts.noise,
+                       uint64_t(first_row) * cols * 3);
+}
+
+}  // namespace
+
+void encode_tiled(const string& carrier_path, istream& file, uint64_t size,
+                  const string& encoded_path, seed_t seed, const options& opts)
+{
+    check_tiled(opts);
+    raw_reader carrier(carrier_path);
+    check_color(carrier, carrier_path);
+    raw_writer encoded(encoded_path, carrier.rows(), carrier.cols(), CV_8UC3);
+
+    // every band holds a share of the file in proportion to its rows (the
+    // first one seed and payload header too), so bands are encoded one after
+    // another in bounded memory; the first band is written last, once the
+    // payload checksum is hidden in it
+    const int rows = band_rows(carrier.cols());
+    const int bands = (carrier.rows() + rows - 1) / rows;
+    slot_embedder embed(opts, seed);
+    // offsets within a band
+    const uint64_t band_size = uint64_t(rows) * carrier.cols() * 3;
+    slot_offsets piece_slots(band_size);
+    slot_offsets header_slots(band_size);
+    vector<uint32_t> order;
+    vector<char> chunk;
+    uint32_t crc = 0;
+    Mat first_band, band;
+
+    // largest file the carrier holds: the smallest limit of its bands, those
+    // before band b giving limit
+    auto carrier_limit = [&](int b, uint64_t limit) {
+        for (; b < bands; ++b) {
+            const int first_row = b * rows;
+            const int count = min(rows, carrier.rows() - first_row);
+            carrier.read(first_row, count, band);
+            Mat_<Vec3b> noised = band;
+            noise_band(noised, first_row, carrier.cols(), seed, opts);
+            limit = min(limit, share_limit(band_capacity(noised, b, opts),
+                                           count, carrier.rows()));
+        }
+        return limit;
+    };
+
+    uint64_t limit = UINT64_MAX;
+    try {
+        for (int b = 0; b < bands; ++b) {
+            const int first_row = b * rows;
+            const int count = min(rows, carrier.rows() - first_row);
+            auto& target = b == 0 ? first_band : band;
+            carrier.read(first_row, count, target);
+            Mat_<Vec3b> noised = target;
+            noise_band(noised, first_row, carrier.cols(), seed, opts);
+
+            // checking the share of the band against its free slots before
+            // anything is hidden in it
+            auto first = share_start(size, first_row, carrier.rows());
+            auto end = share_start(size, first_row + count, carrier.rows());
+            auto capacity = band_capacity(noised, b, opts);
+            limit = min(limit,
+                        share_limit(capacity, count, carrier.rows()));
+            if (end - first > capacity)
+                throw error("Message file is too big (carrier image holds " +
+                            to_string(carrier_limit(b + 1, limit)) +
+                            " bytes)");
+
+            band_slots slots(
+                opts.embed == embedding::additive ? noised.ptr<uchar>()
+                                                  : nullptr,
+                noised.total() * 3, seed, b, opts, order);
+            auto hide = [&](const char* data, size_t count) {
+                embed_piece(noised.ptr<uchar>(), slots, data, count,
+                            opts.bits, embed, piece_slots);
+            };
+
+            if (b == 0) {
+                // hiding seed variable (for password checking) and reserving
+                // slots of payload header (or hiding bare file size)
+                auto seed_piece = header_piece(seed);
+                hide(seed_piece.data(), seed_piece.size());
+                if (opts.payload_header) {
+                    draw_piece(slots, payload_header_bytes, opts.bits,
+                               header_slots);
+                } else {
+                    auto size_piece = header_piece(size);
+                    hide(size_piece.data(), size_piece.size());
+                }
+            }
+
+            // hiding share of the band, chunk by chunk
+            for (; first < end; first += chunk_bytes) {
+                auto count = size_t(min<uint64_t>(chunk_bytes, end - first));
+                chunk.resize(count);
+                if (!file.read(chunk.data(), count))
+                    throw error("Could not read message file");
+                add(counter::bytes_read, count);
+                crc = crc32c(chunk.data(), count, crc);
+                hide(chunk.data(), count);
+            }
+            if (b != 0)
+                encoded.write(first_row, noised);
+        }
+    } catch (const out_of_slots&) {
+        throw error("Message file is too big");
+    }
+    if (opts.payload_header) {
+        payload_header header;
+        header.size = size;
+        header.crc = crc;
+        auto piece = payload_piece(header);
+        embed_drawn(first_band.ptr<uchar>(), header_slots, piece.data(),
+                    piece.size(), opts.bits, embed);
+    }
+    encoded.write(0, first_band);
+    encoded.close();
+}
+
+uint64_t decode_tiled(const string& carrier_path, const string& encoded_path,
+                      ostream& file, seed_t seed, const options& opts)
+{
+    check_tiled(opts);
+    // blind decoding of LSB embeddings needs no carrier
+    const bool blind = carrier_path.empty();
+    if (!blind && opts.embed != embedding::additive)
+        throw error("LSB embeddings are decoded without carrier");
+    raw_reader encoded(encoded_path);
+    check_color(encoded, encoded_path);
+    unique_ptr<raw_reader> carrier;
+    if (!blind) {
+        carrier.reset(new raw_reader(carrier_path));
+        check_color(*carrier, carrier_path);
+        if (carrier->rows() != encoded.rows() ||
+            carrier->cols() != encoded.cols())
+            throw error("Images have different dimensions");
+    }
+
+    const int rows = band_rows(encoded.cols());
+    const int bands = (encoded.rows() + rows - 1) / rows;
+    uint64_t file_size = 0;
+    payload_header header;
+    uint32_t crc = 0;
+    slot_offsets piece_slots(uint64_t(rows) * encoded.cols() * 3);
+    vector<uint32_t> order;
+    vector<char> chunk;
+    Mat encoded_band, carrier_band;
+    try {
+        for (int b = 0; b < bands; ++b) {
+            const int first_row = b * rows;
+            const int count = min(rows, encoded.rows() - first_row);
+            encoded.read(first_row, count, encoded_band);
+            Mat_<Vec3b> noised;
+            if (!blind) {
+                carrier->read(first_row, count, carrier_band);
+                noised = carrier_band;
+                noise_band(noised, first_row, encoded.cols(), seed, opts);
+            }
+            band_slots slots(blind ? nullptr : noised.ptr<uchar>(),
+                             uint64_t(encoded_band.total()) * 3, seed, b,
+                             opts, order);
+            slot_extractor extract(encoded_band,
+                                   blind ? nullptr : noised.ptr<uchar>(),
+                                   opts.bits);
+            auto read = [&](char* data, size_t count,
+                            uint32_t* crc = nullptr) {
+                extract_piece(extract, slots, data, count, opts.bits,
+                              piece_slots, crc);
+            };
+
+            if (b == 0) {
+                // reading seed variable (for password checking) and payload
+                // header (or bare file size)
+                vector<char> seed_piece(sizeof(seed));
+                read(seed_piece.data(), seed_piece.size());
+                if (header_value<seed_t>(seed_piece) != seed)
+                    throw error("Wrong password");
+                if (opts.payload_header) {
+                    vector<char> piece(payload_header_bytes);
+                    read(piece.data(), piece.size());
+                    header = read_payload_header(piece);
+                    if (header.algorithm != compression::none)
+                        throw error("Tiled images hold uncompressed "
+                                    "payloads only");
+                    file_size = header.size;
+                } else {
+                    vector<char> size_piece(sizeof(uint64_t));
+                    read(size_piece.data(), size_piece.size());
+                    file_size = header_value<uint64_t>(size_piece);
+                }
+                if (file_size > uint64_t(encoded.rows()) * encoded.cols() *
+                                    3 * opts.bits / 8)
+                    throw error("Corrupted message file size");
+            }
+
+            // reading share of the band, chunk by chunk
+            auto first = share_start(file_size, first_row, encoded.rows());
+            auto end = share_start(file_size, first_row + count,
+                                   encoded.rows());
+            for (; first < end; first += chunk_bytes) {
+                auto count = size_t(min<uint64_t>(chunk_bytes, end - first));
+                chunk.resize(count);
+                read(chunk.data(), count, &crc);
+                if (!file.write(chunk.data(), count))
+                    throw error("Could not write decoded message");
+                add(counter::bytes_written, count);
+            }
+        }
+    } catch (const out_of_slots&) {
+        throw error("Wrong password");
+    }
+    if (opts.payload_header && crc != header.crc)
+        throw error("Corrupted message file (checksum mismatch)");
+    return file_size;
+}
+
+}  // namespace part_e
+}  // namespace stego
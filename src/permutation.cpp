@@ -0,0 +1,57 @@
+// Steganography library - lazy permutation
+
+#include "stego/permutation.h"
+
+namespace stego {
+
+lazy_permutation::lazy_permutation(std::uint64_t size, cv::RNG& rng)
+    : size_(size), rng_(&rng)
+{
+}
+
+lazy_permutation::lazy_permutation(std::uint64_t size, chacha_rng& rng)
+    : size_(size), chacha_(&rng)
+{
+}
+
+std::uint64_t lazy_permutation::next()
+{
+    auto left = size_ - position_;
+    auto chosen = position_ + (chacha_ ? uniform(*chacha_, left)
+                                       : uniform(*rng_, left));
+    auto value = value_at(chosen);
+    if (chosen != position_)
+        swapped_[chosen] = value_at(position_);
+    swapped_.erase(position_++);  // positions behind are never read again
+    return value;
+}
+
+std::uint64_t lazy_permutation::value_at(std::uint64_t index) const
+{
+    auto it = swapped_.find(index);
+    return it == swapped_.end() ? index : it->second;
+}
+
+std::uint64_t uniform(cv::RNG& rng, std::uint64_t n)
+{
+    if (n <= UINT32_MAX)
+        return rng(unsigned(n));
+    std::uint64_t high = rng.next();
+    return ((high << 32) | rng.next()) % n;
+}
+
+std::uint64_t uniform(chacha_rng& rng, std::uint64_t n)
+{
+    if (n <= UINT32_MAX)
+        return rng(unsigned(n));
+    // rejecting the lowest 2^64 % n values leaves a multiple of n
+    auto threshold = (0 - n) % n;
+    for (;;) {
+        std::uint64_t high = rng.next();
+        auto value = (high << 32) | rng.next();
+        if (value >= threshold)
+            return value % n;
+    }
+}
+
+}  // namespace stego
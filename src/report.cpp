@@ -0,0 +1,275 @@
+// Steganography library - instrumentation
+
+#include "stego/report.h"
+#include "stego/common.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <utility>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+namespace stego {
+
+namespace {
+
+atomic<uint64_t> counters[counter_count];
+
+const char* const counter_names[counter_count] = {
+    "slots_scanned", "retries", "bytes_read", "bytes_written"};
+
+double milliseconds_since(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() -
+                                           start).count();
+}
+
+string format_ms(double ms)
+{
+    char text[32];
+    snprintf(text, sizeof(text), "%.1f ms", ms);
+    return text;
+}
+
+}  // namespace
+
+void add(counter which, uint64_t n)
+{
+    counters[int(which)].fetch_add(n, memory_order_relaxed);
+}
+
+uint64_t value(counter which)
+{
+    return counters[int(which)].load(memory_order_relaxed);
+}
+
+const char* name(counter which)
+{
+    return counter_names[int(which)];
+}
+
+void reset_counters()
+{
+    for (auto& c : counters)
+        c.store(0, memory_order_relaxed);
+}
+
+uint64_t peak_rss()
+{
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#ifdef __APPLE__
+    return uint64_t(usage.ru_maxrss);  // bytes
+#else
+    return uint64_t(usage.ru_maxrss) * 1024;  // KiB
+#endif
+#endif
+}
+
+string json_string(const string& text)
+{
+    string result = "\"";
+    for (unsigned char c : text)
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += char(c);
+        } else if (c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            result += escaped;
+        } else {
+            result += char(c);
+        }
+    return result + '"';
+}
+
+report_format parse_report_format(const string& text)
+{
+    if (text == "text")
+        return report_format::text;
+    if (text == "json")
+        return report_format::json;
+    if (text == "quiet")
+        return report_format::quiet;
+    throw error("Unknown report format " + text);
+}
+
+report::stage::stage(report* owner, string name, string subject)
+    : owner_(owner),
+      name_(move(name)),
+      subject_(move(subject)),
+      start_(chrono::steady_clock::now())
+{
+}
+
+report::stage::stage(stage&& other) noexcept
+    : owner_(other.owner_),
+      name_(move(other.name_)),
+      subject_(move(other.subject_)),
+      start_(other.start_)
+{
+    other.owner_ = nullptr;
+}
+
+report::stage& report::stage::operator=(stage&& other) noexcept
+{
+    if (this != &other) {
+        if (owner_)
+            finish(false, "");
+        owner_ = other.owner_;
+        name_ = move(other.name_);
+        subject_ = move(other.subject_);
+        start_ = other.start_;
+        other.owner_ = nullptr;
+    }
+    return *this;
+}
+
+report::stage::~stage()
+{
+    if (owner_)
+        finish(false, "");
+}
+
+void report::stage::done(const string& detail)
+{
+    if (owner_)
+        finish(true, detail);
+}
+
+void report::stage::fail(const string& message)
+{
+    if (owner_)
+        finish(false, message);
+}
+
+void report::stage::finish(bool ok, const string& detail)
+{
+    auto owner = owner_;
+    owner_ = nullptr;
+    auto ms = milliseconds_since(start_);
+    switch (owner->format_) {
+    case report_format::text:
+        // name and subject were printed by begin
+        if (ok) {
+            owner->out_ << "done ("
+                        << (detail.empty() ? "" : detail + ", ")
+                        << format_ms(ms) << ")\n";
+        } else {
+            owner->out_ << detail << '\n';
+            owner->out_.flush();  // failures are shown at once
+        }
+        break;
+    default:
+        owner->record(name_, subject_, ok, ms, detail);
+    }
+}
+
+report::report(report_format format, ostream& out)
+    : format_(format), out_(out), start_(chrono::steady_clock::now())
+{
+}
+
+report::stage report::begin(const string& name, const string& subject)
+{
+    if (format_ == report_format::text) {
+        // flushed with the summary or a failure, not once per stage
+        out_ << name << (subject.empty() ? "" : " (" + subject + ")")
+             << "... ";
+    }
+    return stage(this, name, subject);
+}
+
+void report::record(const string& name, const string& subject, bool ok,
+                    double milliseconds, const string& detail)
+{
+    switch (format_) {
+    case report_format::text:
+        out_ << name << (subject.empty() ? "" : " (" + subject + ")")
+             << "... ";
+        if (ok)
+            out_ << "done (" << (detail.empty() ? "" : detail + ", ")
+                 << format_ms(milliseconds) << ")\n";
+        else
+            out_ << detail << '\n';
+        break;
+    case report_format::json:
+        out_ << "{\"stage\":" << json_string(name);
+        if (!subject.empty())
+            out_ << ",\"subject\":" << json_string(subject);
+        out_ << ",\"ok\":" << (ok ? "true" : "false") << ",\"ms\":"
+             << milliseconds;
+        if (!detail.empty())
+            out_ << (ok ? ",\"detail\":" : ",\"error\":")
+                 << json_string(detail);
+        out_ << "}\n";
+        break;
+    case report_format::quiet:
+        if (!ok)
+            cerr << name << (subject.empty() ? "" : " (" + subject + ")")
+                 << ": " << detail << '\n';
+        return;
+    }
+    if (!ok)
+        out_.flush();
+}
+
+void report::fail(const string& message)
+{
+    switch (format_) {
+    case report_format::text:
+        out_ << message << '\n';
+        break;
+    case report_format::json:
+        out_ << "{\"ok\":false,\"error\":" << json_string(message) << "}\n";
+        break;
+    case report_format::quiet:
+        cerr << message << '\n';
+        return;
+    }
+    out_.flush();
+}
+
+void report::prompt(const string& text)
+{
+    if (format_ == report_format::text) {
+        out_ << text;
+        out_.flush();
+    }
+}
+
+void report::summary()
+{
+    auto ms = milliseconds_since(start_);
+    switch (format_) {
+    case report_format::text:
+        out_ << "Total " << format_ms(ms) << ", peak memory "
+             << peak_rss() / (1024 * 1024) << " MiB";
+        for (int i = 0; i < counter_count; ++i) {
+            string counter_name = name(counter(i));
+            replace(counter_name.begin(), counter_name.end(), '_', ' ');
+            out_ << ", " << value(counter(i)) << ' ' << counter_name;
+        }
+        out_ << '\n';
+        break;
+    case report_format::json:
+        out_ << "{\"summary\":true,\"ms\":" << ms
+             << ",\"peak_rss\":" << peak_rss();
+        for (int i = 0; i < counter_count; ++i)
+            out_ << ",\"" << name(counter(i)) << "\":" << value(counter(i));
+        out_ << "}\n";
+        break;
+    case report_format::quiet:
+        return;
+    }
+    out_.flush();
+}
+
+}  // namespace stego
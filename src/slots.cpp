@@ -0,0 +1,194 @@
+// Steganography library - free slots
+
+#include "stego/slots.h"
+#include "stego/report.h"
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define STEGO_SLOTS_SSE2
+#endif
+
+using namespace cv;
+using namespace std;
+
+namespace stego {
+
+namespace {
+
+// bytes turned into one mask, bit i set when byte i is a free slot
+constexpr size_t block = 64;
+
+// bytes of a band of rows scanned by one task
+constexpr size_t band_bytes = size_t(1) << 18;
+
+uint64_t free_mask(const uchar* bytes)
+{
+#ifdef STEGO_SLOTS_SSE2
+    const auto full = _mm_set1_epi8(char(255));
+    uint64_t taken = 0;
+    for (int k = 0; k < 4; ++k) {
+        auto b = _mm_loadu_si128((const __m128i*)(bytes + 16 * k));
+        taken |= uint64_t(unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(b, full))))
+                 << (16 * k);
+    }
+    return ~taken;
+#else
+    uint64_t mask = 0;
+    for (size_t i = 0; i < block; ++i)
+        mask |= uint64_t(bytes[i] < 255) << i;
+    return mask;
+#endif
+}
+
+// the same for the last count (fewer than block) bytes of a row
+uint64_t free_mask(const uchar* bytes, size_t count)
+{
+    uint64_t mask = 0;
+    for (size_t i = 0; i < count; ++i)
+        mask |= uint64_t(bytes[i] < 255) << i;
+    return mask;
+}
+
+int popcount(uint64_t mask)
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(mask);
+#else
+    int count = 0;
+    for (; mask; mask &= mask - 1)
+        ++count;
+    return count;
+#endif
+}
+
+int lowest_bit(uint64_t mask)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(mask);
+#else
+    int bit = 0;
+    for (; !(mask & 1); mask >>= 1)
+        ++bit;
+    return bit;
+#endif
+}
+
+size_t count_free(const uchar* bytes, size_t count)
+{
+    size_t free = 0;
+    size_t i = 0;
+    for (; i + block <= count; i += block)
+        free += popcount(free_mask(bytes + i));
+    return free + popcount(free_mask(bytes + i, count - i));
+}
+
+// stores offsets first + i of set bits i of mask, returns end of stored
+// offsets; blocks without 255 bytes (the usual ones) are stored as a run
+template <typename Index>
+Index* store_free(uint64_t mask, Index first, Index* out)
+{
+    if (mask == ~uint64_t(0)) {
+        for (size_t i = 0; i < block; ++i)
+            out[i] = first + Index(i);
+        return out + block;
+    }
+    for (; mask; mask &= mask - 1)
+        *out++ = first + Index(lowest_bit(mask));
+    return out;
+}
+
+template <typename Index>
+Index* compact_free(const uchar* bytes, size_t count, Index first, Index* out)
+{
+    size_t i = 0;
+    for (; i + block <= count; i += block)
+        out = store_free(free_mask(bytes + i), first + Index(i), out);
+    return store_free(free_mask(bytes + i, count - i), first + Index(i), out);
+}
+
+// counts free slots of bands of rows into counts
+class count_bands : public ParallelLoopBody {
+public:
+    count_bands(const Mat_<Vec3b>& image, int band_rows, size_t* counts)
+        : image_(image), band_rows_(band_rows), counts_(counts)
+    {
+    }
+
+    void operator()(const Range& bands) const override
+    {
+        auto row_bytes = size_t(image_.cols) * 3;
+        for (int band = bands.start; band < bands.end; ++band) {
+            size_t count = 0;
+            auto end = min(image_.rows, (band + 1) * band_rows_);
+            for (int row = band * band_rows_; row < end; ++row)
+                count += count_free(image_.ptr<uchar>(row), row_bytes);
+            counts_[band] = count;
+        }
+    }
+
+private:
+    const Mat_<Vec3b>& image_;
+    int band_rows_;
+    size_t* counts_;
+};
+
+// stores offsets of free slots of bands of rows from their first positions
+template <typename Index>
+class compact_bands : public ParallelLoopBody {
+public:
+    compact_bands(const Mat_<Vec3b>& image, int band_rows,
+                  const size_t* firsts, Index* slots)
+        : image_(image), band_rows_(band_rows), firsts_(firsts), slots_(slots)
+    {
+    }
+
+    void operator()(const Range& bands) const override
+    {
+        auto row_bytes = size_t(image_.cols) * 3;
+        for (int band = bands.start; band < bands.end; ++band) {
+            auto out = slots_ + firsts_[band];
+            auto end = min(image_.rows, (band + 1) * band_rows_);
+            for (int row = band * band_rows_; row < end; ++row)
+                out = compact_free(image_.ptr<uchar>(row), row_bytes,
+                                   Index(row * row_bytes), out);
+        }
+    }
+
+private:
+    const Mat_<Vec3b>& image_;
+    int band_rows_;
+    const size_t* firsts_;
+    Index* slots_;
+};
+
+}  // namespace
+
+template <typename Index>
+vector<Index> free_slots(const Mat_<Vec3b>& image)
+{
+    auto row_bytes = size_t(image.cols) * 3;
+    auto band_rows =
+        int(max<size_t>(1, band_bytes / max<size_t>(1, row_bytes)));
+    auto bands = (image.rows + band_rows - 1) / band_rows;
+
+    // counting free slots of every band, so that the table is allocated at
+    // its final size and every band knows where its slots go (prefix sums)
+    vector<size_t> firsts(size_t(bands) + 1, 0);
+    parallel_for_(Range(0, bands),
+                  count_bands(image, band_rows, firsts.data() + 1));
+    partial_sum(firsts.begin(), firsts.end(), firsts.begin());
+
+    vector<Index> slots(firsts.back());
+    parallel_for_(Range(0, bands), compact_bands<Index>(image, band_rows,
+                                                        firsts.data(),
+                                                        slots.data()));
+    add(counter::slots_scanned, image.total() * 3);
+    return slots;
+}
+
+template vector<uint32_t> free_slots(const Mat_<Vec3b>& image);
+template vector<uint64_t> free_slots(const Mat_<Vec3b>& image);
+
+}  // namespace stego
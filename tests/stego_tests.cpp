@@ -0,0 +1,657 @@
+// Steganography tests
+// Usage: stego_tests
+
+// Description
+// Checks run by CTest: of the part E payload path (payload header round trips
+// and rejection of corrupted images, CRC32C against the standard check value
+// and its combination of parts, compressed round trips, and tiled round
+// trips over raw images written to a temporary directory), of results which
+// must not depend on the number of threads or on encoding in place, and of
+// slot orders, which are part of the image format. Every check prints its
+// name and result; the program exits with 1 when any of them fails.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include "stego/crc32c.h"
+#include "stego/stego.h"
+
+using namespace cv;
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+const stego::seed_t seed = 0x5EED;
+
+// thrown by CHECK, ends the current test
+struct failure {
+    string message;
+};
+
+#define CHECK(condition)                                                   \
+    do {                                                                   \
+        if (!(condition))                                                  \
+            throw failure{string(#condition) + " (line " +                 \
+                          to_string(__LINE__) + ")"};                      \
+    } while (0)
+
+// true when call throws stego::error
+bool throws(const function<void()>& call)
+{
+    try {
+        call();
+    } catch (const stego::error&) {
+        return true;
+    }
+    return false;
+}
+
+// carrier of random bytes, low enough for every byte to be free
+Mat_<Vec3b> random_carrier(int rows, int cols, uint64_t state)
+{
+    RNG rng(state);
+    Mat_<Vec3b> carrier(rows, cols);
+    rng.fill(carrier, RNG::UNIFORM, 0, 250);
+    return carrier;
+}
+
+string random_payload(size_t size, uint64_t state)
+{
+    RNG rng(state);
+    string payload(size, '\0');
+    for (auto& c : payload)
+        c = char(rng.uniform(0, 256));
+    return payload;
+}
+
+string decoded(const Mat_<Vec3b>& carrier, const Mat_<Vec3b>& encoded,
+               const stego::part_e::options& opts = {})
+{
+    auto bytes = stego::part_e::decode(carrier, encoded, seed, opts);
+    return string(bytes.begin(), bytes.end());
+}
+
+// true when both images have the same size, type and pixels
+bool same(const Mat& a, const Mat& b)
+{
+    if (a.size() != b.size() || a.type() != b.type())
+        return false;
+    const auto row_bytes = size_t(a.cols) * a.elemSize();
+    for (int row = 0; row < a.rows; ++row)
+        if (memcmp(a.ptr(row), b.ptr(row), row_bytes) != 0)
+            return false;
+    return true;
+}
+
+// restores every n-th byte changed by encoding to its noised value, so that
+// some hidden bits are lost
+Mat_<Vec3b> damaged(const Mat_<Vec3b>& carrier, const Mat_<Vec3b>& encoded,
+                    int n)
+{
+    auto noised = stego::part_e::prepare(carrier, seed).noised;
+    Mat_<Vec3b> result = encoded.clone();
+    auto bytes = result.ptr<uchar>();
+    auto original = noised.ptr<uchar>();
+    int changed = 0;
+    for (size_t i = 0; i < result.total() * 3; ++i)
+        if (bytes[i] != original[i] && ++changed % n == 0)
+            bytes[i] = original[i];
+    return result;
+}
+
+void header_round_trip()
+{
+    auto carrier = random_carrier(120, 160, 1);
+    for (size_t size : {size_t(0), size_t(1), size_t(5000)}) {
+        auto payload = random_payload(size, size);
+        auto encoded = stego::part_e::encode(carrier, payload.data(),
+                                             payload.size(), seed);
+        CHECK(decoded(carrier, encoded) == payload);
+    }
+
+    // images without header are read with --no-header only
+    auto payload = random_payload(3000, 2);
+    stego::part_e::options bare;
+    bare.payload_header = false;
+    auto encoded = stego::part_e::encode(carrier, payload.data(),
+                                         payload.size(), seed, bare);
+    CHECK(decoded(carrier, encoded, bare) == payload);
+    CHECK(throws([&] { decoded(carrier, encoded); }));
+}
+
+void header_rejects_corruption()
+{
+    auto carrier = random_carrier(120, 160, 3);
+    auto payload = random_payload(5000, 4);
+    auto encoded = stego::part_e::encode(carrier, payload.data(),
+                                         payload.size(), seed);
+    CHECK(throws([&] { decoded(carrier, damaged(carrier, encoded, 7)); }));
+    CHECK(throws([&] { decoded(carrier, damaged(carrier, encoded, 500)); }));
+
+    // nothing is written to the stream before the header is checked
+    auto other = random_carrier(120, 160, 5);
+    ostringstream out;
+    CHECK(throws([&] {
+        stego::part_e::decode(other, encoded, out, seed);
+    }));
+    CHECK(out.str().empty());
+}
+
+void crc32c_check_value()
+{
+    const string check = "123456789";
+    CHECK(stego::crc32c(check.data(), check.size()) == 0xE3069283);
+    CHECK(stego::crc32c(check.data(), 0) == 0);
+
+    // chunk by chunk
+    auto crc = stego::crc32c(check.data(), 4);
+    CHECK(stego::crc32c(check.data() + 4, 5, crc) == 0xE3069283);
+}
+
+void crc32c_combine_parts()
+{
+    const string check = "123456789";
+    auto first = stego::crc32c(check.data(), 4);
+    auto second = stego::crc32c(check.data() + 4, 5);
+    CHECK(stego::crc32c_combine(first, second, 5) == 0xE3069283);
+    CHECK(stego::crc32c_combine(first, 0, 0) == first);
+
+    // buffers split into parallel blocks give the serial checksum
+    auto data = random_payload(size_t(5) << 20 | 12345, 6);
+    uint32_t serial = 0;
+    for (size_t first = 0; first < data.size(); first += 1000)
+        serial = stego::crc32c(data.data() + first,
+                               min<size_t>(1000, data.size() - first),
+                               serial);
+    CHECK(stego::crc32c(data.data(), data.size()) == serial);
+
+    // so do blocks of one size combined by a prepared combiner
+    const stego::crc32c_combiner next_block(1000);
+    uint32_t combined = 0;
+    size_t block = 0;
+    for (; block + 1000 <= data.size(); block += 1000)
+        combined = next_block(combined,
+                              stego::crc32c(data.data() + block, 1000));
+    combined = stego::crc32c(data.data() + block, data.size() - block,
+                             combined);
+    CHECK(combined == serial);
+}
+
+// text-like payload, which compresses well
+string text_payload(size_t size)
+{
+    string payload;
+    for (int line = 0; payload.size() < size; ++line)
+        payload += "line " + to_string(line % 97) + " of the message\n";
+    payload.resize(size);
+    return payload;
+}
+
+void compression_streams()
+{
+    auto payload = text_payload(300000);
+    for (auto method : {stego::compression::none,
+                        stego::compression::deflate}) {
+        // fed in uneven chunks, as files are read
+        string compressed;
+        auto append_to = [](string& out) {
+            return [&out](const char* data, size_t size) {
+                out.append(data, size);
+            };
+        };
+        stego::compressor deflater(method);
+        for (size_t first = 0; first < payload.size(); first += 7777)
+            deflater.write(payload.data() + first,
+                           min<size_t>(7777, payload.size() - first),
+                           append_to(compressed));
+        deflater.finish(append_to(compressed));
+        if (method == stego::compression::deflate)
+            CHECK(compressed.size() < payload.size() / 4);
+
+        string restored;
+        stego::decompressor inflater(method);
+        for (size_t first = 0; first < compressed.size(); first += 1000)
+            inflater.write(compressed.data() + first,
+                           min<size_t>(1000, compressed.size() - first),
+                           append_to(restored));
+        CHECK(restored == payload);
+        CHECK(method == stego::compression::none || inflater.finished());
+    }
+    CHECK(stego::parse_compression("deflate") ==
+          stego::compression::deflate);
+    CHECK(throws([] { stego::parse_compression("lz4"); }));
+}
+
+void compressed_round_trip()
+{
+    auto carrier = random_carrier(120, 160, 9);
+    stego::part_e::options deflate;
+    deflate.compress = stego::compression::deflate;
+
+    // bigger than the carrier holds uncompressed
+    auto capacity = stego::part_e::capacity(carrier, seed, deflate);
+    for (const auto& payload : {string(), text_payload(1),
+                                text_payload(size_t(capacity) * 3)}) {
+        auto encoded = stego::part_e::encode(carrier, payload.data(),
+                                             payload.size(), seed, deflate);
+        // decoders find the method in the payload header
+        CHECK(decoded(carrier, encoded) == payload);
+        ostringstream out;
+        CHECK(stego::part_e::decode(carrier, encoded, out, seed) ==
+              payload.size());
+        CHECK(out.str() == payload);
+    }
+
+    // blind decoding, and incompressible payloads which do not fit
+    auto lsb = deflate;
+    lsb.embed = stego::part_e::embedding::lsb_matching;
+    auto payload = text_payload(20000);
+    auto encoded = stego::part_e::encode(carrier, payload.data(),
+                                         payload.size(), seed, lsb);
+    auto blind = stego::part_e::decode_blind(encoded, seed, lsb);
+    CHECK(string(blind.begin(), blind.end()) == payload);
+    auto noise = random_payload(size_t(capacity) + 1000, 10);
+    CHECK(throws([&] {
+        stego::part_e::encode(carrier, noise.data(), noise.size(), seed,
+                              deflate);
+    }));
+}
+
+void compressed_rejects_corruption()
+{
+    auto carrier = random_carrier(120, 160, 11);
+    stego::part_e::options deflate;
+    deflate.compress = stego::compression::deflate;
+    auto payload = text_payload(50000);
+    auto encoded = stego::part_e::encode(carrier, payload.data(),
+                                         payload.size(), seed, deflate);
+    CHECK(throws([&] { decoded(carrier, damaged(carrier, encoded, 50)); }));
+
+    // compression needs the header recording it, tiled images do not
+    // compress
+    auto bare = deflate;
+    bare.payload_header = false;
+    CHECK(throws([&] {
+        stego::part_e::encode(carrier, payload.data(), payload.size(), seed,
+                              bare);
+    }));
+    istringstream in(payload);
+    CHECK(throws([&] {
+        stego::part_e::encode_tiled("carrier.sraw", in, payload.size(),
+                                    "encoded.sraw", seed, deflate);
+    }));
+}
+
+// temporary directory removed with this object
+class temporary_directory {
+public:
+    temporary_directory()
+        : path_(fs::temp_directory_path() /
+                ("stego_tests_" +
+                 to_string(chrono::steady_clock::now()
+                               .time_since_epoch()
+                               .count())))
+    {
+        fs::create_directories(path_);
+    }
+
+    ~temporary_directory()
+    {
+        error_code ignored;
+        fs::remove_all(path_, ignored);
+    }
+
+    string file(const string& name) const { return (path_ / name).string(); }
+
+private:
+    fs::path path_;
+};
+
+void tiled_round_trip()
+{
+    temporary_directory directory;
+    // 1399 rows of 1000 pixels: a full band and a band of a single row
+    auto carrier_path = directory.file("carrier.sraw");
+    CHECK(stego::write_image(carrier_path, random_carrier(1399, 1000, 7)));
+    auto encoded_path = directory.file("encoded.sraw");
+
+    stego::part_e::options lsb;
+    lsb.embed = stego::part_e::embedding::lsb_matching;
+    lsb.bits = 2;
+    for (const auto& opts : {stego::part_e::options(), lsb}) {
+        auto payload = random_payload(100000, 8);
+        istringstream in(payload);
+        stego::part_e::encode_tiled(carrier_path, in, payload.size(),
+                                    encoded_path, seed, opts);
+        ostringstream out;
+        const bool blind = opts.embed != stego::part_e::embedding::additive;
+        auto size = stego::part_e::decode_tiled(
+            blind ? "" : carrier_path, encoded_path, out, seed, opts);
+        CHECK(size == payload.size());
+        CHECK(out.str() == payload);
+
+        ostringstream wrong;
+        CHECK(throws([&] {
+            stego::part_e::decode_tiled(blind ? "" : carrier_path,
+                                        encoded_path, wrong, seed + 1, opts);
+        }));
+    }
+
+    // files too big for a band are rejected with the size the carrier
+    // holds, which fits
+    auto too_big = random_payload(600000, 13);
+    istringstream in(too_big);
+    uint64_t limit = 0;
+    try {
+        stego::part_e::encode_tiled(carrier_path, in, too_big.size(),
+                                    encoded_path, seed);
+    } catch (const stego::error& e) {
+        string message = e.what();
+        auto digits = message.find_first_of("0123456789");
+        CHECK(digits != string::npos);
+        limit = stoull(message.substr(digits));
+    }
+    CHECK(limit > 0 && limit < too_big.size());
+    istringstream fitting(too_big.substr(0, limit));
+    stego::part_e::encode_tiled(carrier_path, fitting, limit, encoded_path,
+                                seed);
+    ostringstream out;
+    stego::part_e::decode_tiled(carrier_path, encoded_path, out, seed);
+    CHECK(out.str() == too_big.substr(0, limit));
+}
+
+// number of OpenCV threads set for the lifetime of this object
+class thread_count {
+public:
+    explicit thread_count(int threads) : previous_(getNumThreads())
+    {
+        setNumThreads(threads);
+    }
+
+    ~thread_count() { setNumThreads(previous_); }
+
+private:
+    int previous_;
+};
+
+void noise_thread_independence()
+{
+    // odd row length, so that rows start inside generator blocks
+    auto carrier = random_carrier(257, 131, 12);
+    for (auto generator : {stego::noise_generator::counter,
+                           stego::noise_generator::chacha}) {
+        Mat_<Vec3b> serial, parallel;
+        {
+            thread_count threads(1);
+            stego::add_gaussian_noise(carrier, serial, 3.0, seed, generator);
+        }
+        {
+            thread_count threads(8);
+            stego::add_gaussian_noise(carrier, parallel, 3.0, seed,
+                                      generator);
+        }
+        CHECK(same(serial, parallel));
+        CHECK(!same(serial, carrier));
+
+        // bands noised on their own, as tiled encoding does
+        Mat_<Vec3b> band(carrier.rowRange(100, 157).clone());
+        stego::add_gaussian_noise(band, band, 3.0, seed, generator,
+                                  uint64_t(100) * carrier.cols * 3);
+        CHECK(same(band, serial.rowRange(100, 157)));
+    }
+}
+
+void parallel_matches_serial()
+{
+    auto carrier = random_carrier(600, 800, 14);
+    auto payload = random_payload(150000, 15);
+    stego::part_e::options matching, replacement;
+    matching.embed = stego::part_e::embedding::lsb_matching;
+    matching.bits = 3;
+    replacement.embed = stego::part_e::embedding::lsb_replacement;
+    replacement.bits = 2;
+    for (const auto& opts :
+         {stego::part_e::options(), matching, replacement}) {
+        Mat_<Vec3b> serial, parallel;
+        {
+            thread_count threads(1);
+            serial = stego::part_e::encode(carrier, payload.data(),
+                                           payload.size(), seed, opts);
+        }
+        {
+            thread_count threads(8);
+            parallel = stego::part_e::encode(carrier, payload.data(),
+                                             payload.size(), seed, opts);
+            CHECK(decoded(carrier, serial, opts) == payload);
+        }
+        CHECK(same(serial, parallel));
+        thread_count threads(1);
+        CHECK(decoded(carrier, parallel, opts) == payload);
+    }
+}
+
+// random message plane of rows x cols pixels
+stego::bit_plane random_plane(int rows, int cols, uint64_t state)
+{
+    RNG rng(state);
+    stego::bit_plane plane(rows, cols);
+    for (int r = 0; r < rows; ++r)
+        for (int c = 0; c < cols; ++c)
+            plane.set(r, c, rng.uniform(0, 2) == 1);
+    return plane;
+}
+
+void in_place_matches_copy()
+{
+    // part E, from memory and from a stream
+    auto carrier = random_carrier(200, 300, 16);
+    auto payload = random_payload(20000, 17);
+    auto copied = stego::part_e::encode(stego::part_e::prepare(carrier, seed),
+                                        payload.data(), payload.size());
+    Mat_<Vec3b> own = carrier.clone();
+    auto prepared = stego::part_e::prepare_in_place(own, seed);
+    auto in_place = stego::part_e::encode_in_place(prepared, payload.data(),
+                                                   payload.size());
+    CHECK(same(in_place, copied));
+    own = carrier.clone();
+    prepared = stego::part_e::prepare_in_place(own, seed);
+    istringstream in(payload);
+    CHECK(same(stego::part_e::encode_in_place(prepared, in, payload.size()),
+               copied));
+
+    // part D (messages of carrier size), on continuous and non-continuous
+    // carriers in both orders
+    auto message = random_plane(200, 300, 18);
+    Mat_<Vec3b> framed = random_carrier(220, 320, 19);
+    auto window_of = [](const Mat_<Vec3b>& image) {
+        return image(Range(10, 210), Range(10, 310));
+    };
+    for (auto order : {stego::part_d::order::permutation,
+                       stego::part_d::order::legacy})
+        for (bool continuous : {true, false}) {
+            auto image = continuous ? carrier : window_of(framed);
+            auto expected = stego::part_d::encode(image, message, seed, order);
+            auto target = continuous ? carrier.clone()
+                                     : window_of(framed.clone());
+            stego::part_d::encode_in_place(target, message, seed, order);
+            CHECK(same(target, expected));
+            CHECK(stego::part_d::decode_bits(image, target, seed, order) ==
+                  message);
+        }
+}
+
+void permutation_determinism()
+{
+    // the order is part of the image format: the first elements of a
+    // ChaCha-keyed permutation are fixed
+    stego::chacha_rng chacha(seed);
+    stego::lazy_permutation fixed(1000, chacha);
+    for (uint64_t expected : {803, 910, 563, 987, 377, 115})
+        CHECK(fixed.next() == expected);
+
+    // every element is taken once, in the same order for the same seed
+    for (bool use_chacha : {true, false}) {
+        vector<uint64_t> orders[2];
+        for (auto& order : orders) {
+            stego::chacha_rng chacha_rng(seed);
+            RNG rng(seed);
+            auto permutation =
+                use_chacha ? stego::lazy_permutation(1000, chacha_rng)
+                           : stego::lazy_permutation(1000, rng);
+            while (!permutation.empty())
+                order.push_back(permutation.next());
+        }
+        CHECK(orders[0] == orders[1]);
+        auto sorted = orders[0];
+        sort(sorted.begin(), sorted.end());
+        for (uint64_t i = 0; i < 1000; ++i)
+            CHECK(sorted[i] == i);
+    }
+
+    // part D slots, whatever the number of threads
+    auto carrier = random_carrier(150, 200, 20);
+    vector<size_t> slots[2];
+    for (int threads : {1, 8}) {
+        thread_count count(threads);
+        slots[threads == 8] = stego::part_d::prepare(carrier, seed).slots;
+    }
+    CHECK(!slots[0].empty() && slots[0] == slots[1]);
+}
+
+// grayscale image of random values from [low, high)
+Mat_<uchar> random_gray(int rows, int cols, uint64_t state, int low = 0,
+                        int high = 256)
+{
+    RNG rng(state);
+    Mat_<uchar> image(rows, cols);
+    rng.fill(image, RNG::UNIFORM, low, high);
+    return image;
+}
+
+void part_a_kernels_match_scalar()
+{
+    // widths around the 16- and 32-byte vector lengths, and windows of
+    // larger images, which are processed row by row
+    for (int cols : {1, 15, 16, 17, 31, 33, 63, 65, 101}) {
+        auto framed_carrier = random_gray(9, cols + 6, cols);
+        // mostly black message pixels, some neither 0 nor 255
+        auto framed_message = random_gray(9, cols + 6, cols + 1000, 0, 3);
+        auto framed_other = random_gray(9, cols + 6, cols + 2000);
+        for (bool continuous : {true, false}) {
+            auto window = [&](const Mat_<uchar>& image) {
+                auto part = image(Range(1, 8), Range(3, cols + 3));
+                return continuous ? part.clone() : part;
+            };
+            auto carrier = window(framed_carrier);
+            auto message = window(framed_message);
+            auto other = window(framed_other);
+            auto encoded = stego::part_a::encode(carrier, message);
+            auto decoded = stego::part_a::decode(carrier, other);
+            for (int r = 0; r < carrier.rows; ++r)
+                for (int c = 0; c < carrier.cols; ++c) {
+                    auto pixel = carrier(r, c);
+                    CHECK(encoded(r, c) ==
+                          (message(r, c) == 0 && pixel < 255 ? pixel + 1
+                                                             : pixel));
+                    CHECK(decoded(r, c) == (other(r, c) <= pixel ? 255 : 0));
+                }
+            // message pixels 0 are read back black, others white
+            auto read = stego::part_a::decode(carrier, encoded);
+            for (int r = 0; r < carrier.rows; ++r)
+                for (int c = 0; c < carrier.cols; ++c)
+                    if (carrier(r, c) < 255)
+                        CHECK(read(r, c) == (message(r, c) == 0 ? 0 : 255));
+        }
+    }
+}
+
+void bit_plane_round_trip()
+{
+    // widths around 64-pixel words, whole images and windows
+    for (int cols : {1, 63, 64, 65, 130}) {
+        auto framed = random_gray(12, cols + 4, cols + 3000, 0, 3);
+        auto window = framed(Range(1, 11), Range(2, cols + 2));
+        for (const auto& image : {framed, window}) {
+            auto plane = stego::bit_plane::from_image(image);
+            // white pixels are those different from 0
+            size_t white = 0;
+            for (int r = 0; r < image.rows; ++r)
+                for (int c = 0; c < image.cols; ++c) {
+                    CHECK(plane.get(r, c) == (image(r, c) != 0));
+                    white += image(r, c) != 0;
+                }
+            CHECK(plane.count() == white);
+            auto saved = plane.to_image();
+            CHECK(stego::bit_plane::from_image(saved) == plane);
+            for (int r = 0; r < image.rows; ++r)
+                for (int c = 0; c < image.cols; ++c)
+                    CHECK(saved(r, c) == (image(r, c) != 0 ? 255 : 0));
+
+            // part A on planes gives the same images as on 8-bit messages
+            auto carrier = random_gray(image.rows, image.cols, cols);
+            auto encoded = stego::part_a::encode(carrier, plane);
+            CHECK(same(encoded, stego::part_a::encode(carrier, image)));
+            CHECK(stego::part_a::decode_bits(carrier, encoded) ==
+                  stego::bit_plane::from_image(
+                      stego::part_a::decode(carrier, encoded)));
+        }
+    }
+
+    // part D the same
+    auto carrier = random_carrier(40, 70, 21);
+    auto message = random_plane(40, 70, 22);
+    auto encoded = stego::part_d::encode(carrier, message, seed);
+    CHECK(same(encoded,
+               stego::part_d::encode(carrier, message.to_image(), seed)));
+    CHECK(stego::part_d::decode_bits(carrier, encoded, seed) == message);
+    CHECK(same(stego::part_d::decode(carrier, encoded, seed),
+               message.to_image()));
+}
+
+}  // namespace
+
+int main()
+{
+    const vector<pair<const char*, function<void()>>> tests = {
+        {"header_round_trip", header_round_trip},
+        {"header_rejects_corruption", header_rejects_corruption},
+        {"crc32c_check_value", crc32c_check_value},
+        {"crc32c_combine_parts", crc32c_combine_parts},
+        {"compression_streams", compression_streams},
+        {"compressed_round_trip", compressed_round_trip},
+        {"compressed_rejects_corruption", compressed_rejects_corruption},
+        {"tiled_round_trip", tiled_round_trip},
+        {"noise_thread_independence", noise_thread_independence},
+        {"parallel_matches_serial", parallel_matches_serial},
+        {"in_place_matches_copy", in_place_matches_copy},
+        {"permutation_determinism", permutation_determinism},
+        {"part_a_kernels_match_scalar", part_a_kernels_match_scalar},
+        {"bit_plane_round_trip", bit_plane_round_trip},
+    };
+    int failed = 0;
+    for (const auto& test : tests) {
+        cout << test.first << "... " << flush;
+        try {
+            test.second();
+            cout << "ok" << endl;
+        } catch (const failure& f) {
+            cout << "FAILED: " << f.message << endl;
+            ++failed;
+        } catch (const exception& e) {
+            cout << "FAILED: " << e.what() << endl;
+            ++failed;
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,106 @@
+// Simple Steganography - decoder
+// Usage: program_name [--png-level N] [--report text|json|quiet]
+//        carrier encoded decoded
+
+// Program recovers the original text from an encoded image produced with
+// encoder.
+
+// Author: Marcin Majkowski, m.p.majkowski@cranfield.ac.uk
+
+// testing.png message:
+//
+// This is a secret message from a secret person.
+// If you can see this message then your program works
+// Well done - on the next part of the practical ......
+//
+// Cranfield University - AMAC, SOE, DIP 1 Practical
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include "stego/image_io.h"
+#include "stego/part_a.h"
+#include "stego/report.h"
+
+using namespace cv;
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    // zlib level of PNG output (raw ".sraw" output is not compressed)
+    auto png_level = stego::default_png_level;
+    // stage times as text, JSON lines or nothing but failures
+    auto report_format = stego::report_format::text;
+    while (argc > 4) {
+        if (string(argv[1]) == "--png-level") {
+            png_level = atoi(argv[2]);
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--report") {
+            try {
+                report_format = stego::parse_report_format(argv[2]);
+            } catch (const stego::error& e) {
+                cout << e.what() << endl;
+                return -1;
+            }
+            argc -= 2;
+            argv += 2;
+        } else {
+            break;
+        }
+    }
+
+    if (argc != 4) {  // incorrect number of arguments
+        cout << "Usage: program_name [--png-level N] "
+             << "[--report text|json|quiet] carrier encoded decoded" << endl;
+        return -1;
+    }
+
+    stego::report report(report_format);
+
+    // loading carrier image
+    auto stage = report.begin("Loading carrier image", argv[1]);
+    auto carrier_file = stego::image_file(argv[1], IMREAD_GRAYSCALE);
+    auto carrier = Mat_<uchar>(carrier_file.image());
+    if (!carrier.data) {
+        stage.fail(string("Could not open or find ") + argv[1]);
+        return -1;
+    }
+    stage.done();
+
+    // loading encoded image
+    stage = report.begin("Loading encoded image", argv[2]);
+    auto encoded_file = stego::image_file(argv[2], IMREAD_GRAYSCALE);
+    auto encoded = Mat_<uchar>(encoded_file.image());
+    if (!encoded.data) {
+        stage.fail(string("Could not open or find ") + argv[2]);
+        return -1;
+    }
+    stage.done();
+
+    // generating decoded image
+    stage = report.begin("Generating decoded image");
+    Mat_<uchar> decoded;
+    try {
+        decoded = stego::part_a::decode(carrier, encoded);
+    } catch (const stego::error& e) {
+        stage.fail(e.what());
+        return -1;
+    }
+    stage.done();
+
+    // saving generated image
+    stage = report.begin("Saving decoded image", argv[3]);
+    if (!stego::write_image(argv[3], decoded, png_level)) {
+        stage.fail(string("Could not save ") + argv[3]);
+        return -1;
+    }
+    stage.done();
+
+    // success
+    report.summary();
+    return 0;
+}
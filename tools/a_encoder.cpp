@@ -0,0 +1,98 @@
+// Simple Steganography - encoder
+// Usage: program_name [--png-level N] [--report text|json|quiet]
+//        carrier message encoded
+
+// Program adds a binary image to a secondary carrier image in order to conceal
+// the bit-mapped text message contained in the binary image.
+
+// Author: Marcin Majkowski, m.p.majkowski@cranfield.ac.uk
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include "stego/image_io.h"
+#include "stego/part_a.h"
+#include "stego/report.h"
+
+using namespace cv;
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    // zlib level of PNG output (raw ".sraw" output is not compressed)
+    auto png_level = stego::default_png_level;
+    // stage times as text, JSON lines or nothing but failures
+    auto report_format = stego::report_format::text;
+    while (argc > 4) {
+        if (string(argv[1]) == "--png-level") {
+            png_level = atoi(argv[2]);
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--report") {
+            try {
+                report_format = stego::parse_report_format(argv[2]);
+            } catch (const stego::error& e) {
+                cout << e.what() << endl;
+                return -1;
+            }
+            argc -= 2;
+            argv += 2;
+        } else {
+            break;
+        }
+    }
+
+    if (argc != 4) {  // incorrect number of arguments
+        cout << "Usage: program_name [--png-level N] "
+             << "[--report text|json|quiet] carrier message encoded" << endl;
+        return -1;
+    }
+
+    stego::report report(report_format);
+
+    // loading carrier image
+    auto stage = report.begin("Loading carrier image", argv[1]);
+    auto carrier_file = stego::image_file(argv[1], IMREAD_GRAYSCALE);
+    auto carrier = Mat_<uchar>(carrier_file.image());
+    if (!carrier.data) {
+        stage.fail(string("Could not open or find ") + argv[1]);
+        return -1;
+    }
+    stage.done();
+
+    // loading message image
+    stage = report.begin("Loading message image", argv[2]);
+    auto message_file = stego::image_file(argv[2], IMREAD_GRAYSCALE);
+    auto message = Mat_<uchar>(message_file.image());
+    if (!message.data) {
+        stage.fail(string("Could not open or find ") + argv[2]);
+        return -1;
+    }
+    stage.done();
+
+    // generating encoded image
+    stage = report.begin("Generating encoded image");
+    Mat_<uchar> encoded;
+    try {
+        encoded = stego::part_a::encode(carrier, message);
+    } catch (const stego::error& e) {
+        stage.fail(e.what());
+        return -1;
+    }
+    stage.done();
+
+    // saving generated image
+    stage = report.begin("Saving encoded image", argv[3]);
+    if (!stego::write_image(argv[3], encoded, png_level)) {
+        stage.fail(string("Could not save ") + argv[3]);
+        return -1;
+    }
+    stage.done();
+
+    // success
+    report.summary();
+    return 0;
+}
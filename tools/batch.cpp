@@ -0,0 +1,121 @@
+// Batch Processing
+// Usage: program_name [-j threads] [--cache dir] [--png-level N]
+//        [--password source] [--report text|json|quiet] manifest
+
+// Description
+// This program runs encoders and decoders of parts B, D and E for every job
+// listed in the manifest (CSV or JSON lines, see stego/batch.h) on a pool of
+// worker threads, printing one result line per job. Password is prompted for
+// once (or read from --password source), only when some job does not give
+// its own. Prepared carriers are kept
+// in the --cache directory for later runs.
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include "stego/batch.h"
+#include "stego/common.h"
+#include "stego/report.h"
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    stego::batch::settings config;
+    // job times as text, JSON lines or nothing but failures
+    auto report_format = stego::report_format::text;
+    // password of jobs without one is prompted for unless --password names
+    // its source (env:NAME, fd:N or file:PATH)
+    string password_source;
+    try {
+        while (argc > 3) {
+            if (string(argv[1]) == "-j")
+                config.threads = unsigned(atoi(argv[2]));
+            else if (string(argv[1]) == "--cache")
+                config.cache_directory = argv[2];
+            else if (string(argv[1]) == "--png-level")
+                config.png_level = atoi(argv[2]);
+            else if (string(argv[1]) == "--password")
+                password_source = argv[2];
+            else if (string(argv[1]) == "--report")
+                report_format = stego::parse_report_format(argv[2]);
+            else
+                break;
+            argc -= 2;
+            argv += 2;
+        }
+    } catch (const stego::error& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+
+    if (argc != 2) {  // incorrect number of arguments
+        cout << "Usage: program_name [-j threads] [--cache dir] "
+             << "[--png-level N] [--password source] "
+             << "[--report text|json|quiet] manifest" << endl;
+        return -1;
+    }
+
+    stego::report report(report_format);
+
+    // loading manifest
+    auto stage = report.begin("Loading manifest", argv[1]);
+    auto manifest = ifstream(argv[1]);
+    if (!manifest.is_open()) {
+        stage.fail(string("Could not open or find ") + argv[1]);
+        return -1;
+    }
+    vector<stego::batch::job> jobs;
+    try {
+        jobs = stego::batch::read_manifest(manifest);
+    } catch (const stego::error& e) {
+        stage.fail(e.what());
+        return -1;
+    }
+    stage.done(to_string(jobs.size()) + " jobs");
+
+    // prompting user for a character string password
+    if (any_of(jobs.begin(), jobs.end(),
+               [](const stego::batch::job& task) {
+                   return !task.has_password;
+               })) {
+        if (password_source.empty()) {
+            report.prompt("Input password: ");
+            getline(cin, config.password);
+        } else {
+            try {
+                config.password = stego::read_password(password_source);
+            } catch (const stego::error& e) {
+                report.fail(e.what());
+                return -1;
+            }
+        }
+    }
+
+    // running jobs, one result line per job
+    int failed = 0;
+    auto start = chrono::steady_clock::now();
+    stego::batch::run(
+        jobs, config,
+        [&](const stego::batch::job& task,
+            const stego::batch::result& outcome) {
+            report.record("line " + to_string(outcome.line) + ": " +
+                              stego::batch::tool_name(task.program),
+                          task.output, outcome.ok, outcome.milliseconds,
+                          outcome.message);
+            failed += !outcome.ok;
+        });
+    report.record(
+        "Running jobs", "", !failed,
+        chrono::duration<double, milli>(chrono::steady_clock::now() - start)
+            .count(),
+        to_string(jobs.size() - failed) + " of " + to_string(jobs.size()) +
+            " jobs done");
+    report.summary();
+
+    // success only when every job succeeded
+    return failed ? -1 : 0;
+}
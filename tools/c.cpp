@@ -0,0 +1,147 @@
+// Generating Noise Images
+// Usage: program_name [--legacy] [--key method] [--rng cv|chacha]
+//        [--png-level N] [--password source] [--report text|json|quiet]
+//        carrier output
+
+// Description
+// This program outputs a version of a given specific input image with noise
+// added according to a Gaussian distribution with sigma value 10.
+
+// Author: Marcin Majkowski, m.p.majkowski@cranfield.ac.uk
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include "stego/image_io.h"
+#include "stego/key.h"
+#include "stego/part_c.h"
+#include "stego/report.h"
+
+using namespace cv;
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    // the original serial cv::RNG noise is generated with --legacy
+    auto generator = stego::noise_generator::chacha;
+    // passwords are turned into seeds with keyed hash unless --key says
+    // otherwise (--legacy implies djb2)
+    auto key = stego::key_params();
+    // zlib level of PNG output (raw ".sraw" output is not compressed)
+    auto png_level = stego::default_png_level;
+    // password is prompted for unless --password names its source
+    string password_source;
+    // stage times as text, JSON lines or nothing but failures
+    auto report_format = stego::report_format::text;
+    while (argc > 3) {
+        if (string(argv[1]) == "--legacy") {
+            generator = stego::noise_generator::legacy;
+            key = stego::key_params::legacy();
+            --argc;
+            ++argv;
+        } else if (string(argv[1]) == "--key") {
+            // --key djb2 reproduces noise generated before keyed derivation
+            try {
+                key = stego::key_params::parse(argv[2]);
+            } catch (const stego::error& e) {
+                cout << e.what() << endl;
+                return -1;
+            }
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--rng") {
+            // --rng cv reproduces noise generated before ChaCha generators
+            // were introduced (Philox noise)
+            auto name = string(argv[2]);
+            if (name == "cv") {
+                generator = stego::noise_generator::counter;
+            } else if (name != "chacha") {
+                cout << "Unknown generator " << name << endl;
+                return -1;
+            }
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--png-level") {
+            png_level = atoi(argv[2]);
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--password") {
+            // env:NAME, fd:N or file:PATH
+            password_source = argv[2];
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--report") {
+            try {
+                report_format = stego::parse_report_format(argv[2]);
+            } catch (const stego::error& e) {
+                cout << e.what() << endl;
+                return -1;
+            }
+            argc -= 2;
+            argv += 2;
+        } else {
+            break;
+        }
+    }
+
+    if (argc != 3) {  // incorrect number of arguments
+        cout << "Usage: program_name [--legacy] [--key method] "
+             << "[--rng cv|chacha] [--png-level N] "
+             << "[--password source] [--report text|json|quiet] carrier "
+             << "output" << endl;
+        return -1;
+    }
+
+    stego::report report(report_format);
+
+    // loading image
+    auto stage = report.begin("Loading carrier image", argv[1]);
+    auto image_file = stego::image_file(argv[1]);
+    auto image = Mat_<Vec3b>{};
+    if (!(image = image_file.image()).data) {
+        stage.fail(string("Could not open or find ") + argv[1]);
+        return -1;
+    }
+    stage.done();
+
+    // prompting user for a character string password (or reading it from
+    // its source)
+    string password;
+    if (password_source.empty()) {
+        report.prompt("Input password: ");
+        getline(cin, password);
+    } else {
+        try {
+            password = stego::read_password(password_source);
+        } catch (const stego::error& e) {
+            report.fail(e.what());
+            return -1;
+        }
+    }
+
+    // transforming password string to a 64-bit integer seed (with key
+    // derivation function)
+    stage = report.begin("Deriving seed");
+    auto seed = stego::derive_seed(password, key);
+    stage.done();
+
+    // adding the Gaussian noise to an image
+    stage = report.begin("Adding Gaussian noise to the image");
+    auto noised = stego::part_c::noise(image, seed, 10, generator);
+    stage.done();
+
+    // save noisy image
+    stage = report.begin("Saving generated image", argv[2]);
+    if (!stego::write_image(argv[2], noised, png_level)) {
+        stage.fail(string("Could not save ") + argv[2]);
+        return -1;
+    }
+    stage.done();
+
+    // success
+    report.summary();
+    return 0;
+}
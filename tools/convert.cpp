@@ -0,0 +1,80 @@
+// Image Conversion
+// Usage: program_name [--gray] [--png-level N] [--report text|json|quiet]
+//        input output
+
+// Description
+// This program converts images between PNG (or any other format readable by
+// OpenCV) and the uncompressed raw format (".sraw", see stego/image_io.h),
+// which the other programs read and write without decoding or compressing.
+// Images are converted to 3 channels, or to 1 channel with --gray.
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include "stego/common.h"
+#include "stego/image_io.h"
+#include "stego/report.h"
+
+using namespace cv;
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    auto flags = IMREAD_COLOR;
+    auto png_level = stego::default_png_level;
+    // stage times as text, JSON lines or nothing but failures
+    auto report_format = stego::report_format::text;
+    while (argc > 3) {
+        if (string(argv[1]) == "--gray") {
+            flags = IMREAD_GRAYSCALE;
+            --argc;
+            ++argv;
+        } else if (string(argv[1]) == "--png-level") {
+            png_level = atoi(argv[2]);
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--report") {
+            try {
+                report_format = stego::parse_report_format(argv[2]);
+            } catch (const stego::error& e) {
+                cout << e.what() << endl;
+                return -1;
+            }
+            argc -= 2;
+            argv += 2;
+        } else {
+            break;
+        }
+    }
+
+    if (argc != 3) {  // incorrect number of arguments
+        cout << "Usage: program_name [--gray] [--png-level N] "
+             << "[--report text|json|quiet] input output" << endl;
+        return -1;
+    }
+
+    stego::report report(report_format);
+
+    // loading image
+    auto stage = report.begin("Loading image", argv[1]);
+    auto file = stego::image_file(argv[1], flags);
+    if (!file.image().data) {
+        stage.fail(string("Could not open or find ") + argv[1]);
+        return -1;
+    }
+    stage.done();
+
+    // saving converted image
+    stage = report.begin("Saving converted image", argv[2]);
+    if (!stego::write_image(argv[2], file.image(), png_level)) {
+        stage.fail(string("Could not save ") + argv[2]);
+        return -1;
+    }
+    stage.done();
+
+    // success
+    report.summary();
+    return 0;
+}
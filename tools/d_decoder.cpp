@@ -0,0 +1,166 @@
+// Extending to Colour Images - decoder
+// Usage: program_name [--legacy] [--key method] [--cache dir]
+//        [--png-level N] [--password source] [--report text|json|quiet]
+//        carrier encoded decoded
+
+// Description
+// This program uses user password seeded random number generator to decode
+// message hidden in noised 3-channel encoded image produced with corresponding
+// encoder.
+
+// Author: Marcin Majkowski, m.p.majkowski@cranfield.ac.uk
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include "stego/carrier_cache.h"
+#include "stego/image_io.h"
+#include "stego/key.h"
+#include "stego/part_d.h"
+#include "stego/report.h"
+
+using namespace cv;
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    // images encoded before permutation order was introduced need --legacy
+    auto slot_order = stego::part_d::order::permutation;
+    // passwords are turned into seeds with keyed hash unless --key says
+    // otherwise (--legacy implies djb2)
+    auto key = stego::key_params();
+    // prepared carriers are kept in cache directory for later runs
+    string cache_directory;
+    // zlib level of PNG output (raw ".sraw" output is not compressed)
+    auto png_level = stego::default_png_level;
+    // password is prompted for unless --password names its source
+    string password_source;
+    // stage times as text, JSON lines or nothing but failures
+    auto report_format = stego::report_format::text;
+    while (argc > 4) {
+        if (string(argv[1]) == "--legacy") {
+            slot_order = stego::part_d::order::legacy;
+            key = stego::key_params::legacy();
+            --argc;
+            ++argv;
+        } else if (string(argv[1]) == "--key") {
+            // images encoded before keyed derivation need --key djb2
+            try {
+                key = stego::key_params::parse(argv[2]);
+            } catch (const stego::error& e) {
+                cout << e.what() << endl;
+                return -1;
+            }
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--cache") {
+            cache_directory = argv[2];
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--png-level") {
+            png_level = atoi(argv[2]);
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--password") {
+            // env:NAME, fd:N or file:PATH
+            password_source = argv[2];
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--report") {
+            try {
+                report_format = stego::parse_report_format(argv[2]);
+            } catch (const stego::error& e) {
+                cout << e.what() << endl;
+                return -1;
+            }
+            argc -= 2;
+            argv += 2;
+        } else {
+            break;
+        }
+    }
+
+    if (argc != 4) {  // incorrect number of arguments
+        cout << "Usage: program_name [--legacy] [--key method] [--cache dir] "
+             << "[--png-level N] [--password source] "
+             << "[--report text|json|quiet] carrier encoded decoded" << endl;
+        return -1;
+    }
+
+    stego::report report(report_format);
+
+    // loading carrier image
+    auto stage = report.begin("Loading carrier image", argv[1]);
+    auto carrier_file = stego::image_file(argv[1]);
+    auto carrier = Mat_<Vec3b>{};
+    if (!(carrier = carrier_file.image()).data) {
+        stage.fail(string("Could not open or find ") + argv[1]);
+        return -1;
+    }
+    stage.done();
+
+    // loading encoded image
+    stage = report.begin("Loading encoded image", argv[2]);
+    auto encoded_file = stego::image_file(argv[2]);
+    auto encoded = Mat_<Vec3b>{};
+    if (!(encoded = encoded_file.image()).data) {
+        stage.fail(string("Could not open or find ") + argv[2]);
+        return -1;
+    }
+    stage.done();
+
+    // prompting user for a character string password (or reading it from
+    // its source)
+    string password;
+    if (password_source.empty()) {
+        report.prompt("Input password: ");
+        getline(cin, password);
+    } else {
+        try {
+            password = stego::read_password(password_source);
+        } catch (const stego::error& e) {
+            report.fail(e.what());
+            return -1;
+        }
+    }
+
+    // transforming password string to a 64-bit integer seed (with key
+    // derivation function)
+    stage = report.begin("Deriving seed");
+    auto seed = stego::derive_seed(password, key);
+    stage.done();
+
+    // reading message bits over the three colour carrier image chanels
+    stage = report.begin(
+        "Reading message bits distributed over carrier image bytes");
+    stego::bit_plane decoded;
+    try {
+        if (cache_directory.empty()) {
+            decoded = stego::part_d::decode_bits(carrier, encoded, seed,
+                                                 slot_order);
+        } else {
+            stego::carrier_cache cache(0, cache_directory);
+            decoded = stego::part_d::decode_bits(
+                *cache.prepare_d(carrier, seed, slot_order), encoded);
+        }
+    } catch (const stego::error& e) {
+        stage.fail(e.what());
+        return -1;
+    }
+    stage.done();
+
+    // saving generated image (unpacked to 0 and 255 pixels)
+    stage = report.begin("Saving decoded image", argv[3]);
+    if (!stego::write_image(argv[3], decoded.to_image(), png_level)) {
+        stage.fail(string("Could not save ") + argv[3]);
+        return -1;
+    }
+    stage.done();
+
+    // success
+    report.summary();
+    return 0;
+}
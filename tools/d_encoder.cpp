@@ -0,0 +1,156 @@
+// Extending to Colour Images - encoder
+// Usage: program_name [--legacy] [--key method] [--png-level N]
+//        [--password source] [--report text|json|quiet] carrier message
+//        encoded
+
+// Description
+// This program uses user password seeded random number generator to hide
+// consequtive bits of binary message image within randomly chosen bytes of
+// noised 3-channel carrier image.
+
+// Author: Marcin Majkowski, m.p.majkowski@cranfield.ac.uk
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include "stego/image_io.h"
+#include "stego/key.h"
+#include "stego/part_d.h"
+#include "stego/report.h"
+
+using namespace cv;
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    // images encoded before permutation order was introduced need --legacy
+    auto slot_order = stego::part_d::order::permutation;
+    // passwords are turned into seeds with keyed hash unless --key says
+    // otherwise (--legacy implies djb2)
+    auto key = stego::key_params();
+    // zlib level of PNG output (raw ".sraw" output is not compressed)
+    auto png_level = stego::default_png_level;
+    // password is prompted for unless --password names its source
+    string password_source;
+    // stage times as text, JSON lines or nothing but failures
+    auto report_format = stego::report_format::text;
+    while (argc > 4) {
+        if (string(argv[1]) == "--legacy") {
+            slot_order = stego::part_d::order::legacy;
+            key = stego::key_params::legacy();
+            --argc;
+            ++argv;
+        } else if (string(argv[1]) == "--key") {
+            // images encoded before keyed derivation need --key djb2
+            try {
+                key = stego::key_params::parse(argv[2]);
+            } catch (const stego::error& e) {
+                cout << e.what() << endl;
+                return -1;
+            }
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--png-level") {
+            png_level = atoi(argv[2]);
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--password") {
+            // env:NAME, fd:N or file:PATH
+            password_source = argv[2];
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--report") {
+            try {
+                report_format = stego::parse_report_format(argv[2]);
+            } catch (const stego::error& e) {
+                cout << e.what() << endl;
+                return -1;
+            }
+            argc -= 2;
+            argv += 2;
+        } else {
+            break;
+        }
+    }
+
+    if (argc != 4) {  // incorrect number of arguments
+        cout << "Usage: program_name [--legacy] [--key method] "
+             << "[--png-level N] [--password source] "
+             << "[--report text|json|quiet] carrier message encoded" << endl;
+        return -1;
+    }
+
+    stego::report report(report_format);
+
+    // loading carrier image
+    auto stage = report.begin("Loading carrier image", argv[1]);
+    auto carrier_file = stego::image_file(argv[1]);
+    auto carrier = Mat_<Vec3b>{};
+    if (!(carrier = carrier_file.image()).data) {
+        stage.fail(string("Could not open or find ") + argv[1]);
+        return -1;
+    }
+    stage.done();
+
+    // loading message image, packed into a bit plane (8 pixels per byte)
+    stage = report.begin("Loading message image", argv[2]);
+    stego::bit_plane message;
+    {  // block limits lifetime of the 8-bit image
+        auto message_file = stego::image_file(argv[2], IMREAD_GRAYSCALE);
+        if (!message_file.image().data) {
+            stage.fail(string("Could not open or find ") + argv[2]);
+            return -1;
+        }
+        message = stego::bit_plane::from_image(message_file.image());
+    }
+    stage.done();
+
+    // prompting user for a character string password (or reading it from
+    // its source)
+    string password;
+    if (password_source.empty()) {
+        report.prompt("Input password: ");
+        getline(cin, password);
+    } else {
+        try {
+            password = stego::read_password(password_source);
+        } catch (const stego::error& e) {
+            report.fail(e.what());
+            return -1;
+        }
+    }
+
+    // transforming password string to a 64-bit integer seed (with key
+    // derivation function)
+    stage = report.begin("Deriving seed");
+    auto seed = stego::derive_seed(password, key);
+    stage.done();
+
+    // distributing message bits over the three colour carrier image chanels
+    stage = report.begin(
+        "Distributing message bits over carrier image bytes");
+    // carrier is encoded in place, the only full-size image
+    auto& encoded = carrier;
+    try {
+        stego::part_d::encode_in_place(carrier, message, seed, slot_order);
+    } catch (const stego::error& e) {
+        stage.fail(e.what());
+        return -1;
+    }
+    stage.done();
+
+    // saving generated image
+    stage = report.begin("Saving encoded image", argv[3]);
+    if (!stego::write_image(argv[3], encoded, png_level)) {
+        stage.fail(string("Could not save ") + argv[3]);
+        return -1;
+    }
+    stage.done();
+
+    // success
+    report.summary();
+    return 0;
+}
@@ -0,0 +1,239 @@
+// General Information Hiding - decoder
+// Usage: program_name [--legacy] [--key method] [--rng cv|chacha] [--bits k]
+//        [--no-header] [--cache dir] [--password source]
+//        [--report text|json|quiet] carrier encoded decoded
+//        program_name --blind [--key method] [--rng cv|chacha] [--bits k]
+//        [--no-header] [--password source] [--report text|json|quiet]
+//        encoded decoded
+//        program_name --tiled [--blind] [options] [carrier] encoded decoded
+
+// Description
+// This program uses user password seeded random number generator to decode
+// file hidden in noised 3-channel encoded image produced with corresponding
+// encoder.
+
+// Program is able to notice wrong password input, therefore cannot produce
+// invalid output file; corrupted images are noticed by the payload header
+// (size and checksum) of the hidden file. Images encoded with --lsb are
+// decoded with --blind, without the carrier image, and images encoded with
+// --bits need the same --bits. Raw (".sraw") images encoded with --tiled are
+// decoded with --tiled, a band of rows at a time.
+
+// Author: Marcin Majkowski, m.p.majkowski@cranfield.ac.uk
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <cstdint>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include "stego/carrier_cache.h"
+#include "stego/image_io.h"
+#include "stego/key.h"
+#include "stego/part_e.h"
+#include "stego/report.h"
+
+using namespace cv;
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    // images encoded before counter noise and permutation order were
+    // introduced need --legacy
+    auto options = stego::part_e::options();
+    // passwords are turned into seeds with keyed hash unless --key says
+    // otherwise (--legacy implies djb2)
+    auto key = stego::key_params();
+    // images encoded with --lsb are decoded without carrier with --blind
+    bool blind = false;
+    // prepared carriers are kept in cache directory for later runs
+    string cache_directory;
+    // password is prompted for unless --password names its source
+    string password_source;
+    // stage times as text, JSON lines or nothing but failures
+    auto report_format = stego::report_format::text;
+    // raw images streamed band by band instead of being loaded
+    bool tiled = false;
+    while (argc > 3) {
+        if (string(argv[1]) == "--legacy") {
+            options = stego::part_e::options::legacy();
+            key = stego::key_params::legacy();
+            --argc;
+            ++argv;
+        } else if (string(argv[1]) == "--key") {
+            // images encoded before keyed derivation need --key djb2
+            try {
+                key = stego::key_params::parse(argv[2]);
+            } catch (const stego::error& e) {
+                cout << e.what() << endl;
+                return -1;
+            }
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--rng") {
+            // images encoded before ChaCha generators were introduced need
+            // --rng cv (cv::RNG slots and Philox noise)
+            auto generator = string(argv[2]);
+            if (generator == "cv") {
+                options.noise = stego::noise_generator::counter;
+                options.slot_generator = stego::random_generator::cv_rng;
+            } else if (generator != "chacha") {
+                cout << "Unknown generator " << generator << endl;
+                return -1;
+            }
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--blind") {
+            blind = true;
+            --argc;
+            ++argv;
+        } else if (string(argv[1]) == "--bits") {
+            options.bits = atoi(argv[2]);
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--cache") {
+            cache_directory = argv[2];
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--password") {
+            // env:NAME, fd:N or file:PATH
+            password_source = argv[2];
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--report") {
+            try {
+                report_format = stego::parse_report_format(argv[2]);
+            } catch (const stego::error& e) {
+                cout << e.what() << endl;
+                return -1;
+            }
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--no-header") {
+            // images encoded before payload headers were introduced hold
+            // the bare message file size
+            options.payload_header = false;
+            --argc;
+            ++argv;
+        } else if (string(argv[1]) == "--tiled") {
+            tiled = true;
+            --argc;
+            ++argv;
+        } else {
+            break;
+        }
+    }
+
+    if (argc != (blind ? 3 : 4)) {  // incorrect number of arguments
+        cout << "Usage: program_name [--legacy] [--key method] "
+             << "[--rng cv|chacha] [--bits k] [--no-header] [--cache dir] "
+             << "[--password source] [--report text|json|quiet] carrier "
+             << "encoded decoded" << endl
+             << "       program_name --blind [--key method] [--rng cv|chacha] "
+             << "[--bits k] [--no-header] [--password source] "
+             << "[--report text|json|quiet] encoded decoded" << endl
+             << "       program_name --tiled [--blind] [options] [carrier] "
+             << "encoded decoded" << endl;
+        return -1;
+    }
+    const char* carrier_path = blind ? nullptr : argv[1];
+    const char* encoded_path = argv[argc - 2];
+    const char* decoded_path = argv[argc - 1];
+    if (tiled && !(stego::is_raw_path(encoded_path) &&
+                   (blind || stego::is_raw_path(carrier_path)))) {
+        cout << "Tiled carrier and encoded images must be raw (.sraw)" << endl;
+        return -1;
+    }
+
+    stego::report report(report_format);
+
+    // loading carrier and encoded images (tiled ones are read band by band
+    // later)
+    auto carrier_file = stego::image_file();
+    auto carrier = Mat_<Vec3b>{};
+    if (!blind && !tiled) {
+        auto stage = report.begin("Loading carrier image", carrier_path);
+        carrier_file = stego::image_file(carrier_path);
+        if (!(carrier = carrier_file.image()).data) {
+            stage.fail(string("Could not open or find ") + carrier_path);
+            return -1;
+        }
+        stage.done();
+    }
+
+    auto encoded_file = stego::image_file();
+    auto encoded = Mat_<Vec3b>{};
+    if (!tiled) {
+        auto stage = report.begin("Loading encoded image", encoded_path);
+        encoded_file = stego::image_file(encoded_path);
+        if (!(encoded = encoded_file.image()).data) {
+            stage.fail(string("Could not open or find ") + encoded_path);
+            return -1;
+        }
+        stage.done();
+    }
+
+    // prompting user for a character string password (or reading it from
+    // its source)
+    string password;
+    if (password_source.empty()) {
+        report.prompt("Input password: ");
+        getline(cin, password);
+    } else {
+        try {
+            password = stego::read_password(password_source);
+        } catch (const stego::error& e) {
+            report.fail(e.what());
+            return -1;
+        }
+    }
+
+    // transforming password string to a 64-bit integer seed (with key
+    // derivation function)
+    auto stage = report.begin("Deriving seed");
+    auto seed = stego::derive_seed(password, key);
+    stage.done();
+
+    // opening decoded message file (it is written in chunks while being read)
+    auto file = ofstream(decoded_path, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        report.fail(string("Could not open or find ") + decoded_path);
+        return -1;
+    }
+
+    // reading seed, message file size and message bits
+    stage = report.begin(
+        "Reading message bits distributed over carrier image bytes to "
+        "decoded message",
+        decoded_path);
+    uint64_t file_size;
+    try {
+        if (tiled) {
+            file_size = stego::part_e::decode_tiled(
+                blind ? "" : carrier_path, encoded_path, file, seed, options);
+        } else if (blind) {
+            file_size =
+                stego::part_e::decode_blind(encoded, file, seed, options);
+        } else if (cache_directory.empty()) {
+            file_size =
+                stego::part_e::decode(carrier, encoded, file, seed, options);
+        } else {
+            stego::carrier_cache cache(0, cache_directory);
+            file_size = stego::part_e::decode(
+                *cache.prepare_e(carrier, seed, options), encoded, file);
+        }
+    } catch (const stego::error& e) {
+        stage.fail(e.what());
+        file.close();
+        remove(decoded_path);  // not producing invalid output file
+        return -1;
+    }
+    stage.done(to_string(file_size * 8) + " bits");
+
+    // success
+    report.summary();
+    return 0;
+}
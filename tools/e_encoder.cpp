@@ -0,0 +1,259 @@
+// General Information Hiding - encoder
+// Usage: program_name [--legacy] [--key method] [--rng cv|chacha]
+//        [--lsb matching|replacement] [--bits k] [--no-header]
+//        [--compress none|deflate] [--png-level N] [--password source]
+//        [--report text|json|quiet] [--tiled] carrier message encoded
+
+// Description
+// This program uses user password seeded random number generator to hide
+// consequtive bits of user selected file within randomly chosen bytes of
+// noised 3-channel carrier image. With --lsb the bits are held by least
+// significant bits of the bytes, so that decoder does not need the carrier.
+// With --bits every chosen byte holds k (up to 4) bits instead of one; the
+// number of bytes the carrier can hold is reported when the file does not
+// fit. With --compress deflate the file is compressed while it is read, so
+// text-like files take fewer bytes of the carrier (e_decoder notices it on
+// its own). With --tiled raw (".sraw") carrier and encoded images of any size
+// are processed a band of rows at a time (decoded with e_decoder --tiled).
+
+// Author: Marcin Majkowski, m.p.majkowski@cranfield.ac.uk
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <fstream>
+#include <cstdint>
+#include <cstdio>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include "stego/compression.h"
+#include "stego/image_io.h"
+#include "stego/key.h"
+#include "stego/part_e.h"
+#include "stego/report.h"
+
+using namespace cv;
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    // images encoded before counter noise and permutation order were
+    // introduced need --legacy
+    auto options = stego::part_e::options();
+    // passwords are turned into seeds with keyed hash unless --key says
+    // otherwise (--legacy implies djb2)
+    auto key = stego::key_params();
+    // zlib level of PNG output (raw ".sraw" output is not compressed)
+    auto png_level = stego::default_png_level;
+    // password is prompted for unless --password names its source
+    string password_source;
+    // stage times as text, JSON lines or nothing but failures
+    auto report_format = stego::report_format::text;
+    // raw images streamed band by band instead of being loaded
+    bool tiled = false;
+    while (argc > 4) {
+        if (string(argv[1]) == "--legacy") {
+            options = stego::part_e::options::legacy();
+            key = stego::key_params::legacy();
+            --argc;
+            ++argv;
+        } else if (string(argv[1]) == "--key") {
+            // images encoded before keyed derivation need --key djb2
+            try {
+                key = stego::key_params::parse(argv[2]);
+            } catch (const stego::error& e) {
+                cout << e.what() << endl;
+                return -1;
+            }
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--rng") {
+            // images encoded before ChaCha generators were introduced need
+            // --rng cv (cv::RNG slots and Philox noise)
+            auto generator = string(argv[2]);
+            if (generator == "cv") {
+                options.noise = stego::noise_generator::counter;
+                options.slot_generator = stego::random_generator::cv_rng;
+            } else if (generator != "chacha") {
+                cout << "Unknown generator " << generator << endl;
+                return -1;
+            }
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--lsb") {
+            // decoded without carrier image (e_decoder --blind)
+            auto mode = string(argv[2]);
+            if (mode == "matching") {
+                options.embed = stego::part_e::embedding::lsb_matching;
+            } else if (mode == "replacement") {
+                options.embed = stego::part_e::embedding::lsb_replacement;
+            } else {
+                cout << "Unknown LSB embedding " << mode << endl;
+                return -1;
+            }
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--bits") {
+            // decoder needs the same --bits
+            options.bits = atoi(argv[2]);
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--png-level") {
+            png_level = atoi(argv[2]);
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--password") {
+            // env:NAME, fd:N or file:PATH
+            password_source = argv[2];
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--report") {
+            try {
+                report_format = stego::parse_report_format(argv[2]);
+            } catch (const stego::error& e) {
+                cout << e.what() << endl;
+                return -1;
+            }
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--no-header") {
+            // images encoded before payload headers were introduced hold
+            // the bare message file size
+            options.payload_header = false;
+            --argc;
+            ++argv;
+        } else if (string(argv[1]) == "--compress") {
+            // recorded in payload header, so not needed by decoder
+            try {
+                options.compress = stego::parse_compression(argv[2]);
+            } catch (const stego::error& e) {
+                cout << e.what() << endl;
+                return -1;
+            }
+            argc -= 2;
+            argv += 2;
+        } else if (string(argv[1]) == "--tiled") {
+            tiled = true;
+            --argc;
+            ++argv;
+        } else {
+            break;
+        }
+    }
+
+    if (argc != 4) {  // incorrect number of arguments
+        cout << "Usage: program_name [--legacy] [--key method] "
+             << "[--rng cv|chacha] [--lsb matching|replacement] [--bits k] "
+             << "[--no-header] [--compress none|deflate] [--png-level N] "
+             << "[--password source] [--report text|json|quiet] [--tiled] "
+             << "carrier message encoded" << endl;
+        return -1;
+    }
+    if (tiled &&
+        !(stego::is_raw_path(argv[1]) && stego::is_raw_path(argv[3]))) {
+        cout << "Tiled carrier and encoded images must be raw (.sraw)" << endl;
+        return -1;
+    }
+
+    stego::report report(report_format);
+
+    // loading carrier image (tiled carrier is read band by band later)
+    auto carrier_file = stego::image_file();
+    auto carrier = Mat_<Vec3b>{};
+    if (!tiled) {
+        auto stage = report.begin("Loading carrier image", argv[1]);
+        carrier_file = stego::image_file(argv[1]);
+        if (!(carrier = carrier_file.image()).data) {
+            stage.fail(string("Could not open or find ") + argv[1]);
+            return -1;
+        }
+        stage.done();
+    }
+
+    // opening message file (it is read in chunks while being hidden)
+    auto stage = report.begin("Opening message file", argv[2]);
+    auto file = ifstream(argv[2], ios::binary | ios::ate);
+    if (!file.is_open()) {
+        stage.fail(string("Could not open or find ") + argv[2]);
+        return -1;
+    }
+    auto file_size = uint64_t(file.tellg());
+    file.seekg(0, ios::beg);
+    stage.done(to_string(file_size * 8) + " bits");
+
+    // prompting user for a character string password (or reading it from
+    // its source)
+    string password;
+    if (password_source.empty()) {
+        report.prompt("Input password: ");
+        getline(cin, password);
+    } else {
+        try {
+            password = stego::read_password(password_source);
+        } catch (const stego::error& e) {
+            report.fail(e.what());
+            return -1;
+        }
+    }
+
+    // transforming password string to a 64-bit integer seed (with key
+    // derivation function)
+    stage = report.begin("Deriving seed");
+    auto seed = stego::derive_seed(password, key);
+    stage.done();
+
+    // streaming carrier bands through noising and encoding to encoded image
+    if (tiled) {
+        stage = report.begin(
+            "Distributing message bits over carrier image bands", argv[3]);
+        try {
+            stego::part_e::encode_tiled(argv[1], file, file_size, argv[3],
+                                        seed, options);
+        } catch (const stego::error& e) {
+            stage.fail(e.what());
+            remove(argv[3]);  // not leaving partly written image
+            return -1;
+        }
+        stage.done();
+        report.summary();
+        return 0;
+    }
+
+    // hiding seed, message file size and message bits in noised carrier image
+    stage = report.begin(
+        "Distributing message bits over carrier image bytes");
+    Mat_<Vec3b> encoded;
+    try {
+        // carrier is noised and encoded in place, the only full-size image
+        auto prepared = stego::part_e::prepare_in_place(carrier, seed,
+                                                        options);
+        // determining if message fits in the carrier image (compressed size
+        // is known once it has been hidden)
+        auto capacity = stego::part_e::capacity(prepared);
+        if (options.compress == stego::compression::none &&
+            file_size > capacity) {
+            stage.fail("Message file is too big (carrier image holds " +
+                       to_string(capacity) + " bytes)");
+            return -1;
+        }
+        encoded = stego::part_e::encode_in_place(prepared, file, file_size);
+    } catch (const stego::error& e) {
+        stage.fail(e.what());
+        return -1;
+    }
+    stage.done();
+
+    // saving generated image
+    stage = report.begin("Saving generated image", argv[3]);
+    if (!stego::write_image(argv[3], encoded, png_level)) {
+        stage.fail(string("Could not save ") + argv[3]);
+        return -1;
+    }
+    stage.done();
+
+    // success
+    report.summary();
+    return 0;
+}
@@ -0,0 +1,296 @@
+// Steganography Daemon
+// Usage: program_name [--cache dir] [--cache-size MiB] [--png-level N]
+//        [--password source] [--report text|json|quiet] socket
+
+// Description
+// This program serves encode and decode jobs of parts B, D and E over a Unix
+// domain socket, so that process start-up is paid once and decoded carriers,
+// prepared carriers and derived seeds stay cached (and OpenCV worker threads
+// warm) between requests. Every request is one line holding a JSON object
+// with the fields of a batch manifest job (see stego/batch.h), answered with
+// one JSON line:
+//
+//   {"request":1,"ok":true,"ms":12.5}
+//   {"request":2,"ok":false,"ms":0.3,"error":"Wrong password"}
+//
+// Images and files are named by path; raw (".sraw") images in shared memory
+// (e.g. /dev/shm) are mapped rather than read. The line "stats" is answered
+// with request count, latency and the library counters, and "shutdown" stops
+// the daemon. Clients are served concurrently, requests of one client in
+// order. Jobs without password use the password read from --password source
+// and fail when it is not given; requests may not name password sources
+// themselves, as these would be read from the daemon's own descriptors,
+// files and environment.
+
+// Author: Marcin Majkowski, m.p.majkowski@cranfield.ac.uk
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <exception>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "stego/batch.h"
+#include "stego/common.h"
+#include "stego/report.h"
+
+using namespace std;
+
+namespace {
+
+// state shared by the threads serving clients
+struct daemon_state {
+    daemon_state(stego::batch::runner& runner, stego::report& report,
+                 bool has_password, int listener)
+        : runner(runner),
+          report(report),
+          has_password(has_password),
+          listener(listener)
+    {
+    }
+
+    stego::batch::runner& runner;
+    stego::report& report;
+    bool has_password;
+    int listener;
+    atomic<bool> stopping{false};
+    mutex lock;  // guards everything below and report
+    set<int> clients;
+    vector<thread::id> finished;  // serving threads to be joined
+    uint64_t requests = 0;
+    uint64_t failed = 0;
+    double total_ms = 0;
+    double max_ms = 0;
+};
+
+bool send_all(int socket, const string& text)
+{
+    for (size_t sent = 0; sent < text.size();) {
+        auto n = ::send(socket, text.data() + sent, text.size() - sent, 0);
+        if (n <= 0)
+            return false;
+        sent += size_t(n);
+    }
+    return true;
+}
+
+string stats_reply(daemon_state& state)
+{
+    lock_guard<mutex> guard(state.lock);
+    auto reply = "{\"requests\":" + to_string(state.requests) +
+                 ",\"failed\":" + to_string(state.failed) + ",\"mean_ms\":" +
+                 to_string(state.requests ? state.total_ms / state.requests
+                                          : 0.0) +
+                 ",\"max_ms\":" + to_string(state.max_ms) +
+                 ",\"peak_rss\":" + to_string(stego::peak_rss());
+    for (int i = 0; i < stego::counter_count; ++i)
+        reply += ",\"" + string(stego::name(stego::counter(i))) +
+                 "\":" + to_string(stego::value(stego::counter(i)));
+    return reply + "}";
+}
+
+// runs the job of request line, returns reply line
+string job_reply(daemon_state& state, const string& line)
+{
+    uint64_t number;
+    {
+        lock_guard<mutex> guard(state.lock);
+        number = ++state.requests;
+    }
+    stego::batch::result outcome;
+    outcome.line = size_t(number);
+    string subject;
+    try {
+        auto task = stego::batch::parse_job(line, size_t(number));
+        subject = string(stego::batch::tool_name(task.program)) + " " +
+                  task.output;
+        if (!task.has_password && !state.has_password)
+            throw stego::error("No password given");
+        outcome = state.runner.run(task);
+    } catch (const exception& e) {
+        // any failure of a request ends the request only, not the daemon
+        outcome.message = e.what();
+    }
+
+    lock_guard<mutex> guard(state.lock);
+    state.failed += !outcome.ok;
+    state.total_ms += outcome.milliseconds;
+    state.max_ms = max(state.max_ms, outcome.milliseconds);
+    state.report.record("request " + to_string(number), subject, outcome.ok,
+                        outcome.milliseconds, outcome.message);
+    auto reply = "{\"request\":" + to_string(number) +
+                 ",\"ok\":" + (outcome.ok ? "true" : "false") +
+                 ",\"ms\":" + to_string(outcome.milliseconds);
+    if (!outcome.ok)
+        reply += ",\"error\":" + stego::json_string(outcome.message);
+    return reply + "}";
+}
+
+// answers request lines of client until it disconnects
+void serve(daemon_state& state, int client)
+{
+    string pending;
+    char buffer[4096];
+    for (;;) {
+        auto n = ::read(client, buffer, sizeof(buffer));
+        if (n <= 0)
+            break;
+        pending.append(buffer, size_t(n));
+        size_t end;
+        while ((end = pending.find('\n')) != string::npos) {
+            auto line = pending.substr(0, end);
+            pending.erase(0, end + 1);
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (line.find_first_not_of(" \t") == string::npos)
+                continue;
+            string reply;
+            if (line == "stats")
+                reply = stats_reply(state);
+            else if (line == "shutdown")
+                reply = "{\"ok\":true}";
+            else
+                reply = job_reply(state, line);
+            if (!send_all(client, reply + "\n"))
+                break;
+            if (line == "shutdown") {
+                // answered first, connected clients are closed afterwards
+                state.stopping = true;
+                ::shutdown(state.listener, SHUT_RDWR);  // ends accept
+            }
+        }
+    }
+    lock_guard<mutex> guard(state.lock);
+    state.clients.erase(client);
+    ::close(client);
+    state.finished.push_back(this_thread::get_id());
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    stego::batch::settings config;
+    // request times as text, JSON lines or nothing but failures
+    auto report_format = stego::report_format::text;
+    // password of jobs without one (env:NAME, fd:N or file:PATH)
+    string password_source;
+    try {
+        while (argc > 3) {
+            if (string(argv[1]) == "--cache")
+                config.cache_directory = argv[2];
+            else if (string(argv[1]) == "--cache-size")
+                config.cache_bytes = size_t(atoll(argv[2])) << 20;
+            else if (string(argv[1]) == "--png-level")
+                config.png_level = atoi(argv[2]);
+            else if (string(argv[1]) == "--password")
+                password_source = argv[2];
+            else if (string(argv[1]) == "--report")
+                report_format = stego::parse_report_format(argv[2]);
+            else
+                break;
+            argc -= 2;
+            argv += 2;
+        }
+        if (!password_source.empty())
+            config.password = stego::read_password(password_source);
+    } catch (const stego::error& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+
+    if (argc != 2) {  // incorrect number of arguments
+        cout << "Usage: program_name [--cache dir] [--cache-size MiB] "
+             << "[--png-level N] [--password source] "
+             << "[--report text|json|quiet] socket" << endl;
+        return -1;
+    }
+    const string socket_path = argv[1];
+
+    stego::report report(report_format);
+
+    // listening on socket (replacing a socket left by a previous daemon)
+    auto stage = report.begin("Listening", socket_path);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        stage.fail("Socket path is too long");
+        return -1;
+    }
+    strcpy(address.sun_path, socket_path.c_str());
+    struct stat status;
+    if (stat(socket_path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode))
+        unlink(socket_path.c_str());
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 ||
+        ::bind(listener, (const sockaddr*)&address, sizeof(address)) != 0 ||
+        ::listen(listener, 16) != 0) {
+        stage.fail("Could not listen on " + socket_path + ": " +
+                   strerror(errno));
+        return -1;
+    }
+    stage.done();
+    signal(SIGPIPE, SIG_IGN);  // clients leaving early are not fatal
+
+    // serving clients until shutdown request
+    stego::batch::runner runner(config);
+    daemon_state state(runner, report, !password_source.empty(), listener);
+    map<thread::id, thread> threads;
+    auto start = chrono::steady_clock::now();
+    while (!state.stopping) {
+        int client = ::accept(listener, nullptr, nullptr);
+        // joining threads of clients gone since, so that their stacks are
+        // not kept for the lifetime of the daemon
+        vector<thread::id> finished;
+        {
+            lock_guard<mutex> guard(state.lock);
+            finished.swap(state.finished);
+        }
+        for (auto id : finished) {
+            threads[id].join();
+            threads.erase(id);
+        }
+        if (client < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        lock_guard<mutex> guard(state.lock);
+        state.clients.insert(client);
+        thread serving(serve, ref(state), client);
+        auto id = serving.get_id();
+        threads.emplace(id, move(serving));
+    }
+    {
+        // waking clients still connected
+        lock_guard<mutex> guard(state.lock);
+        for (auto client : state.clients)
+            ::shutdown(client, SHUT_RDWR);
+    }
+    for (auto& t : threads)
+        t.second.join();
+    ::close(listener);
+    unlink(socket_path.c_str());
+
+    report.record("Serving requests", socket_path, true,
+                  chrono::duration<double, milli>(
+                      chrono::steady_clock::now() - start)
+                      .count(),
+                  to_string(state.requests - state.failed) + " of " +
+                      to_string(state.requests) + " requests done");
+    report.summary();
+    return 0;
+}